@@ -151,6 +151,8 @@ xmreg::MySqlConnectionPool::port      = config_json["database"]["port"];
 xmreg::MySqlConnectionPool::username  = config_json["database"]["user"];
 xmreg::MySqlConnectionPool::password  = config_json["database"]["password"];
 xmreg::MySqlConnectionPool::dbname    = config_json["database"]["dbname"];
+xmreg::MySqlConnectionPool::binary_keys
+        = config_json["database"].value("binary_keys", false);
 
 // number of thread in blockchain access pool thread
 auto threads_no = std::max<uint32_t>(
@@ -0,0 +1,16 @@
+-- Adds AccountChanges, which counts updates and deletes of rows
+-- of each account, so that get_address_txs and get_address_info
+-- can tell when since cursors of clients are no longer valid.
+--
+-- Its already part of openmonero.sql. Apply it only to databases
+-- created before, it doesnt change any existing rows.
+
+USE `bittube`;
+
+CREATE TABLE IF NOT EXISTS `AccountChanges` (
+  `account_id` bigint(20) UNSIGNED NOT NULL,
+  `changes` bigint(20) UNSIGNED NOT NULL DEFAULT '0',
+  PRIMARY KEY (`account_id`),
+  CONSTRAINT `account_id4_FK` FOREIGN KEY (`account_id`)
+    REFERENCES `Accounts` (`id`) ON DELETE CASCADE
+) ENGINE=InnoDB DEFAULT CHARSET=utf8;
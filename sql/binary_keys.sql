@@ -0,0 +1,105 @@
+-- Stores keys and hashes of Transactions, Outputs and Inputs as
+-- binary(32)/varbinary(32) instead of hex varchar(64), which makes
+-- rows and indices on them about half as big.
+--
+-- It can be applied to an existing database, or to a new one just
+-- after openmonero.sql. Existing rows are converted.
+--
+-- The tables are renamed to TransactionsBin, OutputsBin and InputsBin,
+-- and Transactions, Outputs and Inputs become views of them with keys
+-- in hex, so that selects by ids made by the backend dont change.
+-- Rows are inserted directly into the *Bin tables, and lookups by keys
+-- and joins of the tables are done on them too, with UNHEX of the keys,
+-- so that their indices are used.
+--
+-- After applying it, set "binary_keys" to true in config.json.
+
+USE `bittube`;
+
+SET FOREIGN_KEY_CHECKS=0;
+
+-- foreign keys follow renamed tables
+RENAME TABLE `Transactions` TO `TransactionsBin`,
+             `Outputs`      TO `OutputsBin`,
+             `Inputs`       TO `InputsBin`;
+
+-- first change columns to varbinary, so that hex strings
+-- are kept as they are, then convert them to binary
+
+ALTER TABLE `TransactionsBin`
+  MODIFY `hash`        varbinary(64) NOT NULL,
+  MODIFY `prefix_hash` varbinary(64) NOT NULL DEFAULT '',
+  MODIFY `tx_pub_key`  varbinary(64) NOT NULL DEFAULT '';
+
+UPDATE `TransactionsBin`
+  SET `hash`        = UNHEX(`hash`),
+      `prefix_hash` = UNHEX(`prefix_hash`),
+      `tx_pub_key`  = UNHEX(`tx_pub_key`);
+
+ALTER TABLE `TransactionsBin`
+  MODIFY `hash`        binary(32) NOT NULL,
+  MODIFY `prefix_hash` varbinary(32) NOT NULL DEFAULT '',
+  MODIFY `tx_pub_key`  varbinary(32) NOT NULL DEFAULT '';
+
+ALTER TABLE `OutputsBin`
+  MODIFY `out_pub_key` varbinary(64) NOT NULL,
+  MODIFY `rct_outpk`   varbinary(64) NOT NULL DEFAULT '',
+  MODIFY `rct_mask`    varbinary(64) NOT NULL DEFAULT '',
+  MODIFY `rct_amount`  varbinary(64) NOT NULL DEFAULT '',
+  MODIFY `tx_pub_key`  varbinary(64) NOT NULL DEFAULT '';
+
+UPDATE `OutputsBin`
+  SET `out_pub_key` = UNHEX(`out_pub_key`),
+      `rct_outpk`   = UNHEX(`rct_outpk`),
+      `rct_mask`    = UNHEX(`rct_mask`),
+      `rct_amount`  = UNHEX(`rct_amount`),
+      `tx_pub_key`  = UNHEX(`tx_pub_key`);
+
+ALTER TABLE `OutputsBin`
+  MODIFY `out_pub_key` binary(32) NOT NULL,
+  MODIFY `rct_outpk`   varbinary(32) NOT NULL DEFAULT '',
+  MODIFY `rct_mask`    varbinary(32) NOT NULL DEFAULT '',
+  MODIFY `rct_amount`  varbinary(32) NOT NULL DEFAULT '',
+  MODIFY `tx_pub_key`  varbinary(32) NOT NULL DEFAULT '';
+
+ALTER TABLE `InputsBin`
+  MODIFY `key_image` varbinary(64) NOT NULL DEFAULT '';
+
+UPDATE `InputsBin`
+  SET `key_image` = UNHEX(`key_image`);
+
+ALTER TABLE `InputsBin`
+  MODIFY `key_image` binary(32) NOT NULL;
+
+-- views with the same columns as the original tables
+
+CREATE OR REPLACE ALGORITHM=MERGE VIEW `Transactions` AS
+  SELECT `id`,
+         LOWER(HEX(`hash`))        AS `hash`,
+         LOWER(HEX(`prefix_hash`)) AS `prefix_hash`,
+         LOWER(HEX(`tx_pub_key`))  AS `tx_pub_key`,
+         `account_id`, `blockchain_tx_id`,
+         `total_received`, `total_sent`,
+         `unlock_time`, `height`, `spendable`,
+         `coinbase`, `is_rct`, `rct_type`,
+         `payment_id`, `mixin`, `timestamp`
+  FROM `TransactionsBin`;
+
+CREATE OR REPLACE ALGORITHM=MERGE VIEW `Outputs` AS
+  SELECT `id`, `account_id`, `tx_id`,
+         LOWER(HEX(`out_pub_key`)) AS `out_pub_key`,
+         LOWER(HEX(`rct_outpk`))   AS `rct_outpk`,
+         LOWER(HEX(`rct_mask`))    AS `rct_mask`,
+         LOWER(HEX(`rct_amount`))  AS `rct_amount`,
+         LOWER(HEX(`tx_pub_key`))  AS `tx_pub_key`,
+         `amount`, `global_index`, `out_index`,
+         `mixin`, `timestamp`
+  FROM `OutputsBin`;
+
+CREATE OR REPLACE ALGORITHM=MERGE VIEW `Inputs` AS
+  SELECT `id`, `account_id`, `tx_id`, `output_id`,
+         LOWER(HEX(`key_image`)) AS `key_image`,
+         `amount`, `timestamp`
+  FROM `InputsBin`;
+
+SET FOREIGN_KEY_CHECKS=1;
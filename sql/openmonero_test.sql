@@ -66,6 +66,19 @@ INSERT INTO `Accounts` (`id`, `address`, `viewkey_hash`, `scanned_block_height`,
 
 -- --------------------------------------------------------
 
+--
+-- Table structure for table `AccountChanges`
+--
+
+DROP TABLE IF EXISTS `AccountChanges`;
+CREATE TABLE IF NOT EXISTS `AccountChanges` (
+  `account_id` bigint(20) UNSIGNED NOT NULL,
+  `changes` bigint(20) UNSIGNED NOT NULL DEFAULT '0',
+  PRIMARY KEY (`account_id`)
+) ENGINE=InnoDB DEFAULT CHARSET=utf8;
+
+-- --------------------------------------------------------
+
 --
 -- Table structure for table `Inputs`
 --
@@ -430,6 +443,12 @@ INSERT INTO `Transactions` (`id`, `hash`, `prefix_hash`, `tx_pub_key`, `account_
 -- Constraints for dumped tables
 --
 
+--
+-- Constraints for table `AccountChanges`
+--
+ALTER TABLE `AccountChanges`
+  ADD CONSTRAINT `account_id4_FK` FOREIGN KEY (`account_id`) REFERENCES `Accounts` (`id`) ON DELETE CASCADE;
+
 --
 -- Constraints for table `Inputs`
 --
@@ -0,0 +1,267 @@
+#include "BlockCache.h"
+
+namespace xmreg
+{
+
+BlockCache::BlockCache(size_t _max_blocks)
+    : max_blocks {_max_blocks}
+{}
+
+bool
+BlockCache::get_block(uint64_t height, block& blk)
+{
+    std::lock_guard<std::mutex> lck (cache_mtx);
+
+    Entry* entry = find_entry(height);
+
+    if (!entry)
+    {
+        ++misses;
+        return false;
+    }
+
+    ++hits;
+
+    blk = entry->blk;
+
+    return true;
+}
+
+bool
+BlockCache::get_blocks(uint64_t h1, uint64_t h2, vector<block>& blocks)
+{
+    if (h1 > h2)
+        return false;
+
+    std::lock_guard<std::mutex> lck (cache_mtx);
+
+    vector<block> cached_blocks;
+
+    cached_blocks.reserve(h2 - h1 + 1);
+
+    for (uint64_t height = h1; height <= h2; ++height)
+    {
+        Entry* entry = find_entry(height);
+
+        if (!entry)
+        {
+            // if even one block is missing, the whole range
+            // will be read from lmdb anyway
+            misses += h2 - height + 1;
+            return false;
+        }
+
+        ++hits;
+
+        cached_blocks.push_back(entry->blk);
+    }
+
+    blocks = std::move(cached_blocks);
+
+    return true;
+}
+
+void
+BlockCache::put_block(uint64_t height, block const& blk)
+{
+    if (max_blocks == 0)
+        return;
+
+    std::lock_guard<std::mutex> lck (cache_mtx);
+
+    insert_entry(height, blk);
+
+    evict_if_needed();
+}
+
+void
+BlockCache::put_block_txs(uint64_t height,
+                          block const& blk,
+                          vector<crypto::hash> const& txs_hashes,
+                          vector<transaction> const& txs)
+{
+    if (max_blocks == 0 || txs_hashes.size() != txs.size())
+        return;
+
+    std::lock_guard<std::mutex> lck (cache_mtx);
+
+    Entry& entry = insert_entry(height, blk);
+
+    if (!entry.has_txs)
+    {
+        entry.txs_hashes = txs_hashes;
+        entry.txs = txs;
+        entry.has_txs = true;
+
+        for (size_t i = 0; i < txs_hashes.size(); ++i)
+            txs_index[txs_hashes[i]] = {height, i};
+    }
+
+    evict_if_needed();
+}
+
+bool
+BlockCache::get_tx(crypto::hash const& tx_hash, transaction& tx)
+{
+    std::lock_guard<std::mutex> lck (cache_mtx);
+
+    auto it = txs_index.find(tx_hash);
+
+    if (it == txs_index.end())
+    {
+        ++misses;
+        return false;
+    }
+
+    Entry* entry = find_entry(it->second.first);
+
+    if (!entry)
+    {
+        ++misses;
+        return false;
+    }
+
+    ++hits;
+
+    tx = entry->txs.at(it->second.second);
+
+    return true;
+}
+
+bool
+BlockCache::get_block_hash(uint64_t height, crypto::hash& blk_hash)
+{
+    std::lock_guard<std::mutex> lck (cache_mtx);
+
+    auto it = entries.find(height);
+
+    if (it == entries.end())
+        return false;
+
+    // we calculate it only when needed, as its used
+    // only for checking for reorgs of top blocks
+    blk_hash = cryptonote::get_block_hash(it->second.blk);
+
+    return true;
+}
+
+vector<uint64_t>
+BlockCache::get_top_heights(size_t no_of_heights)
+{
+    std::lock_guard<std::mutex> lck (cache_mtx);
+
+    vector<uint64_t> heights;
+
+    for (auto it = entries.rbegin();
+         it != entries.rend() && heights.size() < no_of_heights;
+         ++it)
+    {
+        heights.push_back(it->first);
+    }
+
+    return heights;
+}
+
+void
+BlockCache::invalidate_from(uint64_t height)
+{
+    std::lock_guard<std::mutex> lck (cache_mtx);
+
+    auto it = entries.lower_bound(height);
+
+    while (it != entries.end())
+    {
+        auto to_erase = it++;
+        erase_entry(to_erase);
+    }
+}
+
+size_t
+BlockCache::size()
+{
+    std::lock_guard<std::mutex> lck (cache_mtx);
+    return entries.size();
+}
+
+BlockCache::Entry*
+BlockCache::find_entry(uint64_t height)
+{
+    auto it = entries.find(height);
+
+    if (it == entries.end())
+        return nullptr;
+
+    // mark as most recently used
+    lru_heights.splice(lru_heights.begin(), lru_heights,
+                       it->second.lru_it);
+
+    return &(it->second);
+}
+
+BlockCache::Entry&
+BlockCache::insert_entry(uint64_t height, block const& blk)
+{
+    auto it = entries.find(height);
+
+    if (it != entries.end())
+    {
+        block const& cached_blk = it->second.blk;
+
+        // no need to calculate hashes of the blocks here. if its same
+        // block, these will match.
+        if (cached_blk.prev_id == blk.prev_id
+                && cached_blk.nonce == blk.nonce
+                && cached_blk.timestamp == blk.timestamp
+                && cached_blk.tx_hashes == blk.tx_hashes)
+        {
+            lru_heights.splice(lru_heights.begin(), lru_heights,
+                               it->second.lru_it);
+            return it->second;
+        }
+
+        // different block at the same height, so the blockchain
+        // got reorganized. Everything above it is invalid as well.
+        auto to_erase = it;
+
+        while (to_erase != entries.end())
+            erase_entry(to_erase++);
+    }
+
+    lru_heights.push_front(height);
+
+    Entry& entry = entries[height];
+
+    entry.blk = blk;
+    entry.lru_it = lru_heights.begin();
+
+    return entry;
+}
+
+void
+BlockCache::erase_entry(map<uint64_t, Entry>::iterator it)
+{
+    Entry& entry = it->second;
+
+    for (auto const& tx_hash: entry.txs_hashes)
+    {
+        auto tx_it = txs_index.find(tx_hash);
+
+        if (tx_it != txs_index.end() && tx_it->second.first == it->first)
+            txs_index.erase(tx_it);
+    }
+
+    lru_heights.erase(entry.lru_it);
+
+    entries.erase(it);
+}
+
+void
+BlockCache::evict_if_needed()
+{
+    while (entries.size() > max_blocks && !lru_heights.empty())
+    {
+        erase_entry(entries.find(lru_heights.back()));
+    }
+}
+
+}
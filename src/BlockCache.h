@@ -0,0 +1,132 @@
+#pragma once
+
+#include "src/monero_headers.h"
+
+#include <map>
+#include <list>
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <unordered_map>
+
+namespace xmreg
+{
+
+using namespace cryptonote;
+using namespace crypto;
+using namespace std;
+
+/*
+ * Size-bounded, height-keyed cache of blocks and their txs
+ * read from lmdb.
+ *
+ * Many accounts importing or rescanning overlapping ranges of
+ * the blockchain were reading and deserializing the same blocks
+ * over and over. With this cache, a block and its txs are read only
+ * once, as long as they are not evicted.
+ *
+ * Least recently used blocks are evicted first. Since it is keyed
+ * by height, it must be told when blocks get reorganized using
+ * invalidate_from.
+ */
+class BlockCache
+{
+public:
+
+    // max_blocks of 0 disables the cache
+    BlockCache(size_t _max_blocks);
+
+    virtual bool
+    get_block(uint64_t height, block& blk);
+
+    // returns true only when all blocks from h1 to h2 are
+    // in the cache
+    virtual bool
+    get_blocks(uint64_t h1, uint64_t h2, vector<block>& blocks);
+
+    virtual void
+    put_block(uint64_t height, block const& blk);
+
+    // txs_hashes and txs must include miner tx at
+    // their begining
+    virtual void
+    put_block_txs(uint64_t height,
+                  block const& blk,
+                  vector<crypto::hash> const& txs_hashes,
+                  vector<transaction> const& txs);
+
+    virtual bool
+    get_tx(crypto::hash const& tx_hash, transaction& tx);
+
+    // hash of cached block, used for detecting reorgs
+    virtual bool
+    get_block_hash(uint64_t height, crypto::hash& blk_hash);
+
+    // heights of cached blocks, from the highest one
+    virtual vector<uint64_t>
+    get_top_heights(size_t no_of_heights);
+
+    // removes blocks with heights equal or larger than
+    // the given one. used when a reorg happens.
+    virtual void
+    invalidate_from(uint64_t height);
+
+    virtual size_t
+    size();
+
+    uint64_t
+    get_hits() const {return hits;}
+
+    uint64_t
+    get_misses() const {return misses;}
+
+    virtual ~BlockCache() = default;
+
+private:
+
+    struct Entry
+    {
+        block blk;
+
+        // empty until txs of the block get fetched
+        bool has_txs {false};
+        vector<crypto::hash> txs_hashes;
+        vector<transaction> txs;
+
+        // position in lru_heights
+        list<uint64_t>::iterator lru_it;
+    };
+
+    // no mutex here, this is called from methods
+    // which already lock it
+    Entry*
+    find_entry(uint64_t height);
+
+    Entry&
+    insert_entry(uint64_t height, block const& blk);
+
+    void
+    erase_entry(map<uint64_t, Entry>::iterator it);
+
+    void
+    evict_if_needed();
+
+    size_t max_blocks {0};
+
+    // ordered, so that we can easly invalidate blocks
+    // from a given height
+    map<uint64_t, Entry> entries;
+
+    // most recently used heights are at the front
+    list<uint64_t> lru_heights;
+
+    //                 tx_hash      ,    height , idx in Entry::txs
+    unordered_map<crypto::hash, pair<uint64_t, size_t>> txs_index;
+
+    atomic<uint64_t> hits {0};
+    atomic<uint64_t> misses {0};
+
+    mutex cache_mtx;
+};
+
+}
@@ -0,0 +1,435 @@
+#define MYSQLPP_SSQLS_NO_STATICS 1
+
+#include "BlockScanner.h"
+
+#include "CurrentBlockchainStatus.h"
+
+namespace xmreg
+{
+
+BlockScanner::BlockScanner(
+        CurrentBlockchainStatus* _current_bc_status)
+    : current_bc_status {_current_bc_status}
+{}
+
+void
+BlockScanner::operator()()
+{
+    OMINFO << "Block scanner started";
+
+    workers = std::make_unique<ScanWorkerPool>(
+            current_bc_status->get_bc_setup().scan_threads);
+
+    while (keep_scanning)
+    {
+        bool scanned_something {false};
+
+        // exceptions from individual TxSearch objects are
+        // handled by them. so here we only catch things
+        // like failures in getting blocks from lmdb.
+        try
+        {
+            scanned_something = scan_once();
+        }
+        catch (std::exception const& e)
+        {
+            OMERROR << "Exception in block scanner: " << e.what();
+        }
+        catch (...)
+        {
+            OMERROR << "Exception in block scanner!";
+        }
+
+        if (!scanned_something)
+            wait_for_work();
+    }
+
+    // wait for any ongoing prefetching, as it uses
+    // current_bc_status which can be gone soon
+    prefetched.clear();
+
+    workers.reset();
+
+    OMINFO << "Block scanner stopped";
+}
+
+bool
+BlockScanner::scan_once()
+{
+    auto searches = current_bc_status->get_search_threads();
+
+    //                  searched_blk_no
+    vector<pair<uint64_t, shared_ptr<TxSearch>>> to_scan;
+
+    for (auto& search: searches)
+    {
+        if (!search->still_searching())
+            continue;
+
+        to_scan.emplace_back(search->get_searched_blk_no(), search);
+    }
+
+    // sort by searched_blk_no, so that accounts at similar
+    // heights are next to each other and can share a window
+    std::sort(to_scan.begin(), to_scan.end(),
+              [](auto const& l, auto const& r)
+              {
+                  return l.first < r.first;
+              });
+
+    uint64_t last_block_height = current_bc_status->current_height;
+
+    uint64_t invalid_from;
+
+    {
+        std::lock_guard<std::mutex> lck (wait_mtx);
+        invalid_from = reorg_height;
+        reorg_height = std::numeric_limits<uint64_t>::max();
+    }
+
+    drop_unused_prefetches(to_scan.empty() ? last_block_height + 1
+                                           : to_scan.front().first,
+                           last_block_height, invalid_from);
+
+    bool scanned_something {false};
+
+    // windows being scanned now. we keep only few
+    // windows in flight, as each can take a lot of memory.
+    deque<InFlightWindow> in_flight;
+
+    size_t max_in_flight = workers->size() + 1;
+
+    auto it = to_scan.begin();
+
+    while (it != to_scan.end() && keep_scanning)
+    {
+        uint64_t h1 = it->first;
+
+        if (h1 > last_block_height)
+            break;
+
+        uint64_t h2 = std::min(h1 + get_lookahead(h1) - 1,
+                               last_block_height);
+
+        auto window = get_window(h1, h2);
+
+        // prefetched window could have been made when the
+        // blockchain was shorter, so its h2 can be lower
+        if (window)
+            h2 = window->h2;
+
+        // all accounts whose searched_blk_no falls into [h1, h2]
+        // are going to use the same window
+        auto group_end = std::find_if(it, to_scan.end(),
+                [h2](auto const& s) {return s.first > h2;});
+
+        OMVLOG2 << "analyzing blocks from " << h1 << " to " << h2
+                << " out of " << last_block_height << " blocks for "
+                << std::distance(it, group_end) << " accounts";
+
+        // fetch next windows while we are busy with this one
+        if (window)
+            prefetch_after(*window, last_block_height);
+
+        InFlightWindow in_flight_window;
+
+        in_flight_window.window = window;
+        in_flight_window.tasks = make_shared<ScanTaskGroup>();
+        in_flight_window.max_scan_time = make_shared<atomic<uint64_t>>(0);
+
+        auto max_scan_time = in_flight_window.max_scan_time;
+
+        for (; it != group_end; ++it)
+        {
+            auto search = it->second;
+
+            if (!window)
+            {
+                // same as before, if we cant get blocks
+                // the search for a given account stops
+                search->stop();
+                continue;
+            }
+
+            // each account is only in one group, so no two
+            // tasks scan for the same TxSearch at the same time
+            auto scan_workers = workers.get();
+
+            workers->submit([search, window, max_scan_time, scan_workers]()
+                            {
+                                auto start = chrono::steady_clock::now();
+
+                                search->scan_window(*window, scan_workers);
+
+                                uint64_t took = chrono::duration_cast<
+                                        chrono::microseconds>(
+                                            chrono::steady_clock::now()
+                                            - start).count();
+
+                                // accounts are scanned in parallel, so
+                                // the slowest one is the cost of the window
+                                uint64_t current = *max_scan_time;
+
+                                while (took > current
+                                       && !max_scan_time
+                                            ->compare_exchange_weak(
+                                                current, took));
+                            }, in_flight_window.tasks);
+        }
+
+        in_flight.push_back(std::move(in_flight_window));
+
+        while (in_flight.size() > max_in_flight)
+        {
+            finish_window(in_flight.front());
+            in_flight.pop_front();
+        }
+
+        scanned_something = true;
+    }
+
+    // next round needs updated searched_blk_no of all accounts
+    for (auto& in_flight_window: in_flight)
+        finish_window(in_flight_window);
+
+    // the remaining ones are at the top of the blockchain and
+    // just wait for new blocks. if they were not pinged for
+    // too long, we stop them.
+    for (; it != to_scan.end(); ++it)
+    {
+        it->second->stop_if_not_pinged();
+    }
+
+    return scanned_something;
+}
+
+shared_ptr<ScanWindow>
+BlockScanner::get_window(uint64_t h1, uint64_t h2)
+{
+    auto it = prefetched.find(h1);
+
+    if (it != prefetched.end())
+    {
+        bool reorged;
+
+        {
+            // reorg could be found since the start of scan_once
+            std::lock_guard<std::mutex> lck (wait_mtx);
+            reorged = it->second.h2 >= reorg_height;
+        }
+
+        auto window = it->second.window.get();
+
+        prefetched.erase(it);
+
+        if (window && !reorged)
+            return window;
+
+        // if prefetching failed, try again below. maybe
+        // it was a temporary problem, e.g., a reorg.
+    }
+
+    return current_bc_status->get_scan_window(h1, h2);
+}
+
+void
+BlockScanner::prefetch_after(ScanWindow const& window,
+                             uint64_t last_block_height)
+{
+    auto const& bc_setup = current_bc_status->get_bc_setup();
+
+    uint64_t next_h1 = window.h2 + 1;
+
+    for (uint64_t i = 0; i < bc_setup.blocks_search_prefetch_depth; ++i)
+    {
+        if (next_h1 > last_block_height)
+            break;
+
+        uint64_t next_h2 = std::min(
+                next_h1 + get_lookahead(next_h1) - 1,
+                last_block_height);
+
+        if (prefetched.count(next_h1) == 0)
+        {
+            OMVLOG2 << "prefetching blocks from " << next_h1
+                    << " to " << next_h2;
+
+            prefetched.emplace(next_h1, PrefetchedWindow {
+                    next_h2, std::async(std::launch::async,
+                    [this](uint64_t h1, uint64_t h2)
+                    {
+                        return current_bc_status->get_scan_window(h1, h2);
+                    }, next_h1, next_h2)});
+        }
+
+        next_h1 = next_h2 + 1;
+    }
+}
+
+void
+BlockScanner::finish_window(InFlightWindow& in_flight_window)
+{
+    in_flight_window.tasks->wait();
+
+    if (in_flight_window.window)
+        update_window_cost(*in_flight_window.window,
+                           *in_flight_window.max_scan_time);
+}
+
+uint64_t
+BlockScanner::get_lookahead(uint64_t h1)
+{
+    auto const& bc_setup = current_bc_status->get_bc_setup();
+
+    // nothing scanned yet, so use fixed window size
+    if (txs_per_block.empty())
+        return bc_setup.blocks_search_lookahead;
+
+    // take density of the closest window we scanned
+    // below h1. if there is none, the closest above it.
+    auto it = txs_per_block.upper_bound(h1);
+
+    if (it != txs_per_block.begin())
+        --it;
+
+    // coinbase tx is always there, so its never below 1
+    double density = std::max(it->second, 1.0);
+
+    uint64_t lookahead = bc_setup.blocks_search_lookahead;
+
+    // with time budget, window size follows the scanning time
+    if (bc_setup.blocks_search_target_window_ms > 0 && us_per_tx > 0)
+    {
+        double target_us = bc_setup.blocks_search_target_window_ms * 1000.0;
+
+        lookahead = static_cast<uint64_t>(
+                    target_us / (us_per_tx * density));
+
+        lookahead = std::max(lookahead, bc_setup.blocks_search_lookahead_min);
+        lookahead = std::min(lookahead, bc_setup.blocks_search_lookahead_max);
+    }
+
+    // all txs of a window, and of its prefetched followers, are in
+    // memory at once. fast scanning of dense blocks could otherwise
+    // make windows of up to blocks_search_lookahead_max full blocks
+    if (bc_setup.blocks_search_max_window_txs > 0)
+    {
+        uint64_t max_blocks = std::max<uint64_t>(
+                    static_cast<uint64_t>(
+                        bc_setup.blocks_search_max_window_txs / density),
+                    1);
+
+        lookahead = std::min(lookahead, max_blocks);
+    }
+
+    OMVLOG1 << "lookahead for block " << h1 << ": " << lookahead
+            << " blocks (" << density << " txs per block, "
+            << us_per_tx << " us per tx)";
+
+    return lookahead;
+}
+
+void
+BlockScanner::update_window_cost(ScanWindow const& window,
+                                 uint64_t scan_time_us)
+{
+    if (window.txs.empty())
+        return;
+
+    uint64_t no_of_blocks = window.h2 - window.h1 + 1;
+
+    txs_per_block[window.h1]
+            = static_cast<double>(window.txs.size()) / no_of_blocks;
+
+    // we need only recent windows. the lowest heights are
+    // least likely to be scanned again soon.
+    while (txs_per_block.size() > max_density_entries)
+        txs_per_block.erase(txs_per_block.begin());
+
+    double window_us_per_tx
+            = static_cast<double>(scan_time_us) / window.txs.size();
+
+    // exponential moving average, so that one slow
+    // window, e.g., due to mysql hiccup, does not
+    // change the window size too much
+    us_per_tx = us_per_tx <= 0
+            ? window_us_per_tx
+            : 0.8 * us_per_tx + 0.2 * window_us_per_tx;
+
+    OMVLOG2 << "window " << window.h1 << "-" << window.h2
+            << " with " << window.txs.size() << " txs scanned in "
+            << scan_time_us / 1000 << " ms";
+}
+
+void
+BlockScanner::drop_unused_prefetches(uint64_t min_searched_blk_no,
+                                     uint64_t last_block_height,
+                                     uint64_t reorg_height)
+{
+    auto it = prefetched.begin();
+
+    while (it != prefetched.end())
+    {
+        // all accounts are already past this window, or the
+        // blockchain got shorter due to reorg, or some of its
+        // blocks were replaced by reorg while it was prefetched
+        if (it->first < min_searched_blk_no
+                || it->second.h2 > last_block_height
+                || it->second.h2 >= reorg_height)
+        {
+            // future from std::async waits in its destructor
+            // for the fetch to finish, if its still ongoing
+            it = prefetched.erase(it);
+            continue;
+        }
+
+        ++it;
+    }
+}
+
+void
+BlockScanner::wait_for_work()
+{
+    // new blocks, new accounts and rescans wake us up
+    // through wake_up(). the timeout is only there
+    // to stop accounts that were not pinged for too long.
+    std::unique_lock<std::mutex> lck (wait_mtx);
+
+    wait_cv.wait_for(lck,
+            current_bc_status->get_bc_setup().refresh_block_status_every,
+            [this]() {return work_pending || !keep_scanning;});
+
+    work_pending = false;
+}
+
+void
+BlockScanner::wake_up()
+{
+    {
+        std::lock_guard<std::mutex> lck (wait_mtx);
+        work_pending = true;
+    }
+
+    wait_cv.notify_all();
+}
+
+void
+BlockScanner::invalidate_from(uint64_t height)
+{
+    {
+        std::lock_guard<std::mutex> lck (wait_mtx);
+        reorg_height = std::min(reorg_height, height);
+        work_pending = true;
+    }
+
+    wait_cv.notify_all();
+}
+
+void
+BlockScanner::stop()
+{
+    keep_scanning = false;
+    wake_up();
+}
+
+}
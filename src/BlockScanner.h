@@ -0,0 +1,173 @@
+#pragma once
+
+#include "om_log.h"
+#include "TxSearch.h"
+#include "ScanWorkerPool.h"
+
+#include <map>
+#include <future>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <limits>
+#include <condition_variable>
+
+namespace xmreg
+{
+
+using namespace std;
+
+class CurrentBlockchainStatus;
+
+/*
+ * Single scanning engine for all accounts.
+ *
+ * Before, each account had its own TxSearch thread, and each of these
+ * threads was fetching and deserializing the very same blocks and
+ * txs from lmdb. So with many accounts at the top of the
+ * blockchain, every new block was read as many times as we had
+ * accounts.
+ *
+ * BlockScanner instead groups TxSearch objects by their
+ * searched_blk_no, loads each window of blocks once, and then
+ * lets every TxSearch in that group identify its outputs and inputs
+ * in the shared window. Each TxSearch still keeps track of its
+ * own progress, and hands its results to DbWriter, which writes
+ * them into mysql together with results of other accounts.
+ *
+ * Scanning of a window for each account is a task executed
+ * by ScanWorkerPool, so that many accounts (and many windows)
+ * are scanned in parallel by a fixed number of threads.
+ *
+ * While a window is being scanned, the next windows
+ * (blocks_search_prefetch_depth of them) are already fetched
+ * in the background, so that lmdb reads overlap with identification
+ * of outputs and inputs and with writing to mysql.
+ *
+ * Number of blocks in a window is not fixed. Early blocks are
+ * almost empty while recent ones are full of txs, so the window
+ * size is chosen based on tx density of nearby blocks and measured
+ * scanning time per tx, aiming at blocks_search_target_window_ms.
+ * Its also limited to about blocks_search_max_window_txs txs, as
+ * all of them are kept in memory until the window is scanned.
+ */
+class BlockScanner
+{
+public:
+
+    BlockScanner(CurrentBlockchainStatus* _current_bc_status);
+
+    // main loop of the scanner thread
+    virtual void
+    operator()();
+
+    virtual void
+    stop();
+
+    // wake up the scanner if it waits for a work to do,
+    // e.g., new block was found, new account was added
+    // or rescan was requested
+    virtual void
+    wake_up();
+
+    // blocks from the given height were replaced by a reorg, so
+    // prefetched windows with any of them cant be used. called
+    // from other threads, so its only noted here and the windows
+    // are dropped by the scanner thread
+    virtual void
+    invalidate_from(uint64_t height);
+
+    virtual ~BlockScanner() = default;
+
+protected:
+
+    struct PrefetchedWindow
+    {
+        // as requested. window can end below it
+        uint64_t h2 {0};
+
+        std::future<shared_ptr<ScanWindow>> window;
+    };
+
+    struct InFlightWindow
+    {
+        shared_ptr<ScanWindow> window;
+        shared_ptr<ScanTaskGroup> tasks;
+
+        // of the slowest account in the window
+        shared_ptr<atomic<uint64_t>> max_scan_time;
+    };
+
+    // goes once over all TxSearch objects and scans
+    // one window for each group of them.
+    // returns true if any window was scanned.
+    virtual bool
+    scan_once();
+
+    virtual void
+    wait_for_work();
+
+    // waits for all accounts to scan the window
+    // and updates window cost estimates
+    virtual void
+    finish_window(InFlightWindow& in_flight_window);
+
+    // returns window starting at h1, either already
+    // prefetched or fetched now. nullptr if it fails.
+    virtual shared_ptr<ScanWindow>
+    get_window(uint64_t h1, uint64_t h2);
+
+    // start fetching windows which follow the given one
+    virtual void
+    prefetch_after(ScanWindow const& window, uint64_t last_block_height);
+
+    // number of blocks in a window starting at h1
+    virtual uint64_t
+    get_lookahead(uint64_t h1);
+
+    virtual void
+    update_window_cost(ScanWindow const& window, uint64_t scan_time_us);
+
+    // removes prefetched windows which are not going to
+    // be used by any account, or which have blocks from
+    // reorg_height or above the top of the blockchain
+    virtual void
+    drop_unused_prefetches(uint64_t min_searched_blk_no,
+                           uint64_t last_block_height,
+                           uint64_t reorg_height
+                                = std::numeric_limits<uint64_t>::max());
+
+    CurrentBlockchainStatus* current_bc_status {nullptr};
+
+    std::atomic_bool keep_scanning {true};
+
+    // used to make the scanner sleep when
+    // there is nothing to scan
+    mutex wait_mtx;
+    condition_variable wait_cv;
+    bool work_pending {false};
+
+    // lowest height replaced by reorgs since the last
+    // scan_once. guarded by wait_mtx
+    uint64_t reorg_height {std::numeric_limits<uint64_t>::max()};
+
+    // windows being fetched in the background, keyed by their h1.
+    // std::async is used, not the thread_pool, as get_scan_window
+    // itself submits to the thread_pool and waits for it.
+    map<uint64_t, PrefetchedWindow> prefetched;
+
+    // created when the scanner thread starts
+    unique_ptr<ScanWorkerPool> workers;
+
+    // used to choose window sizes. only
+    // accessed by the scanner thread.
+    double us_per_tx {0};
+
+    //  h1 of a window, txs per block in it
+    map<uint64_t, double> txs_per_block;
+
+    static constexpr size_t max_density_entries {1000};
+};
+
+}
@@ -161,10 +161,49 @@ BlockchainSetup::_init()
 {
     refresh_block_status_every
             = seconds {config_json["refresh_block_status_every_seconds"]};
+    blockchain_height_poll_every
+            = milliseconds {config_json.value(
+                    "blockchain_height_poll_every_milliseconds",
+                    blockchain_height_poll_every.count())};
+    mempool_refresh_every
+            = milliseconds {config_json.value(
+                    "mempool_refresh_every_milliseconds",
+                    mempool_refresh_every.count())};
     blocks_search_lookahead
             = config_json["blocks_search_lookahead"];
+    blocks_search_target_window_ms
+            = config_json.value("blocks_search_target_window_ms",
+                                blocks_search_target_window_ms);
+    blocks_search_lookahead_min
+            = config_json.value("blocks_search_lookahead_min",
+                                blocks_search_lookahead_min);
+    blocks_search_lookahead_max
+            = config_json.value("blocks_search_lookahead_max",
+                                blocks_search_lookahead_max);
+    blocks_search_max_window_txs
+            = config_json.value("blocks_search_max_window_txs",
+                                blocks_search_max_window_txs);
+    blocks_search_prefetch_depth
+            = config_json.value("blocks_search_prefetch_depth",
+                                blocks_search_prefetch_depth);
+    scan_threads
+            = config_json.value("scan_threads", scan_threads);
     max_number_of_blocks_to_import
             = config_json["max_number_of_blocks_to_import"];
+    spend_detection_by_global_index
+            = config_json.value("spend_detection_by_global_index",
+                                spend_detection_by_global_index);
+    ring_member_index_path
+            = config_json.value("ring_member_index_path",
+                                ring_member_index_path);
+    ring_member_index_blocks_per_batch
+            = config_json.value("ring_member_index_blocks_per_batch",
+                                ring_member_index_blocks_per_batch);
+    scan_digest_path
+            = config_json.value("scan_digest_path", scan_digest_path);
+    scan_digest_blocks_per_batch
+            = config_json.value("scan_digest_blocks_per_batch",
+                                scan_digest_blocks_per_batch);
     search_thread_life
             = seconds {config_json["search_thread_life_in_seconds"]};
     import_fee
@@ -173,6 +212,11 @@ BlockchainSetup::_init()
             = seconds {config_json["mysql_ping_every_seconds"]};
     blockchain_treadpool_size 
             = config_json["blockchain_treadpool_size"];
+    block_cache_size
+            = config_json.value("block_cache_size", block_cache_size);
+    db_writer_queue_size
+            = config_json.value("db_writer_queue_size",
+                                db_writer_queue_size);
 
     get_blockchain_path();
 
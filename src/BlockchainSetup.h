@@ -18,6 +18,7 @@ using namespace cryptonote;
 using namespace std;
 
 using chrono::seconds;
+using chrono::milliseconds;
 
 class BlockchainSetup
 {
@@ -42,15 +43,38 @@ public:
     bool do_not_relay {false};
 
     seconds refresh_block_status_every {10};
+    milliseconds blockchain_height_poll_every {1000};
+    milliseconds mempool_refresh_every {1000};
     seconds search_thread_life {120};
     seconds mysql_ping_every {300};
 
     uint64_t blocks_search_lookahead {200};
 
+    uint64_t blocks_search_target_window_ms {2000};
+    uint64_t blocks_search_lookahead_min {10};
+    uint64_t blocks_search_lookahead_max {10000};
+    uint64_t blocks_search_max_window_txs {20000};
+
+    uint64_t blocks_search_prefetch_depth {1};
+
+    uint64_t scan_threads {0};
+
     uint64_t max_number_of_blocks_to_import {132000};
 
+    bool spend_detection_by_global_index {true};
+
+    string   ring_member_index_path;
+    uint64_t ring_member_index_blocks_per_batch {1000};
+
+    string   scan_digest_path;
+    uint64_t scan_digest_blocks_per_batch {1000};
+
     uint64_t blockchain_treadpool_size {0};
 
+    uint64_t block_cache_size {1000};
+
+    uint64_t db_writer_queue_size {64};
+
     string   import_payment_address_str;
     string   import_payment_viewkey_str;
 
@@ -24,6 +24,45 @@ CurrentBlockchainStatus::CurrentBlockchainStatus(
 {
     is_running = false;
     stop_blockchain_monitor_loop = false;
+
+    block_scanner = std::make_unique<BlockScanner>(this);
+
+    block_cache = std::make_unique<BlockCache>(bc_setup.block_cache_size);
+
+    mempool_snapshot = make_shared<MempoolSnapshot const>();
+
+    service_epoch = std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::chrono::system_clock::now().time_since_epoch()).count();
+
+    db_writer = std::make_unique<DbWriter>(bc_setup.db_writer_queue_size);
+
+    if (!bc_setup.ring_member_index_path.empty())
+    {
+        ring_member_index = std::make_unique<RingMemberIndex>(
+                    bc_setup.ring_member_index_path);
+
+        if (!ring_member_index->open())
+        {
+            OMERROR << "Cant open ring member index in "
+                    << bc_setup.ring_member_index_path
+                    << ". Continuing without it.";
+            ring_member_index.reset();
+        }
+    }
+
+    if (!bc_setup.scan_digest_path.empty())
+    {
+        scan_digest = std::make_unique<ScanDigest>(
+                    bc_setup.scan_digest_path);
+
+        if (!scan_digest->open())
+        {
+            OMERROR << "Cant open scan digest in "
+                    << bc_setup.scan_digest_path
+                    << ". Continuing without it.";
+            scan_digest.reset();
+        }
+    }
 }
 
 void
@@ -36,32 +75,126 @@ CurrentBlockchainStatus::monitor_blockchain()
     {
        is_running = true;
 
+       // one thread that scans blocks for all the accounts
+       ThreadRAII block_scanner_thread(
+                   std::thread(std::ref(*block_scanner)),
+                   ThreadRAII::DtorAction::join);
+
+       // scan digest is built in its own thread, as reading
+       // whole blockchain for it takes hours
+       std::unique_ptr<ThreadRAII> scan_digest_thread;
+
+       if (scan_digest)
+           scan_digest_thread = std::make_unique<ThreadRAII>(
+                   std::thread(&CurrentBlockchainStatus::build_scan_digest,
+                               this),
+                   ThreadRAII::DtorAction::join);
+
+       // same for ring member index. its batches were built in
+       // this loop before, delaying checks for new blocks
+       std::unique_ptr<ThreadRAII> ring_member_index_thread;
+
+       if (ring_member_index)
+           ring_member_index_thread = std::make_unique<ThreadRAII>(
+                   std::thread(
+                       &CurrentBlockchainStatus::build_ring_member_index,
+                       this),
+                   ThreadRAII::DtorAction::join);
+
+       // new mempool txs are identified for all accounts in their
+       // own thread, as it needs mysql for txs spending our outputs
+       ThreadRAII mempool_identification_thread(
+                   std::thread(&CurrentBlockchainStatus::identify_mempool_txs,
+                               this),
+                   ThreadRAII::DtorAction::join);
+
+       // height is checked much more often than the rest, as
+       // its just one rpc call and the scanner should
+       // know about new blocks as soon as possible
+       auto last_refresh = std::chrono::steady_clock::now()
+                           - bc_setup.refresh_block_status_every;
+
+       // only new txs are read from the mempool, so it
+       // can be refreshed more often than the rest
+       auto last_mempool_refresh = last_refresh;
+
        while (true)
        {
            if (stop_blockchain_monitor_loop)
            {
+               block_scanner->stop();
                stop_search_threads();
                clean_search_thread_map();
                OMINFO << "Breaking monitor_blockchain thread loop.";
                break;
            }
 
-           //OMVLOG1 << "PoolQueue size: " 
-           OMINFO << "PoolQueue size: " 
-                   << TP::DefaultThreadPool::queueSize(); 
+           uint64_t previous_height = current_height;
 
            update_current_blockchain_height();           
 
-           read_mempool();
+           bool got_new_block = current_height != previous_height;
+
+           auto now = std::chrono::steady_clock::now();
+
+           bool do_refresh = now - last_refresh
+                             >= bc_setup.refresh_block_status_every;
+
+           if (got_new_block || do_refresh)
+               check_block_cache_for_reorg();
+
+           // new block means some txs left the mempool
+           if (got_new_block
+                   || now - last_mempool_refresh
+                        >= bc_setup.mempool_refresh_every)
+           {
+               uint64_t previous_mempool_version = mempool_version;
+
+               read_mempool();
+
+               if (mempool_version != previous_mempool_version)
+               {
+                   {
+                       std::lock_guard<std::mutex> lck (monitor_mtx);
+                       mempool_changed = true;
+                   }
 
-           OMINFO << "Current blockchain height: " << current_height
-                  << ", pool size: " << mempool_txs.size() << " txs"
-                  << ", no of TxSearch threads: " << thread_map_size(); 
+                   monitor_cv.notify_all();
+               }
 
-           clean_search_thread_map();
+               last_mempool_refresh = now;
+           }
+
+           if (got_new_block)
+           {
+               OMVLOG1 << "New block " << current_height;
+
+               // let the scanner process the new block right away
+               block_scanner->wake_up();
+           }
+
+           if (do_refresh)
+           {
+               //OMVLOG1 << "PoolQueue size: " 
+               OMINFO << "PoolQueue size: " 
+                       << TP::DefaultThreadPool::queueSize(); 
+
+               OMINFO << "Current blockchain height: " << current_height
+                      << ", pool size: "
+                      << get_mempool_snapshot()->txs.size() << " txs"
+                      << ", no of TxSearch threads: " << thread_map_size(); 
+
+               OMVLOG1 << "Block cache size: " << block_cache->size()
+                       << " blocks, hits: " << block_cache->get_hits()
+                       << ", misses: " << block_cache->get_misses();
+
+               clean_search_thread_map();
+
+               last_refresh = now;
+           }
 
-           std::this_thread::sleep_for(
-                       bc_setup.refresh_block_status_every);
+           wait_for_monitor_loop(std::min(bc_setup.blockchain_height_poll_every,
+                                          bc_setup.mempool_refresh_every));
        }
 
        is_running = false;
@@ -70,6 +203,26 @@ CurrentBlockchainStatus::monitor_blockchain()
     OMINFO << "Exiting monitor_blockchain thread loop.";
 }
 
+void
+CurrentBlockchainStatus::stop()
+{
+    {
+        std::lock_guard<std::mutex> lck (monitor_mtx);
+        stop_blockchain_monitor_loop = true;
+    }
+
+    monitor_cv.notify_all();
+}
+
+void
+CurrentBlockchainStatus::wait_for_monitor_loop(milliseconds timeout)
+{
+    std::unique_lock<std::mutex> lck (monitor_mtx);
+
+    monitor_cv.wait_for(lck, timeout,
+            [this]() {return stop_blockchain_monitor_loop.load();});
+}
+
 uint64_t
 CurrentBlockchainStatus::get_current_blockchain_height()
 {
@@ -130,10 +283,20 @@ CurrentBlockchainStatus::is_tx_unlocked(
                                          block_height);
 }
 
+UnlockLimits
+CurrentBlockchainStatus::get_unlock_limits(
+        TxUnlockChecker const& tx_unlock_checker)
+{
+    return tx_unlock_checker.get_unlock_limits(bc_setup.net_type,
+                                               current_height);
+}
+
 
 bool
 CurrentBlockchainStatus::get_block(uint64_t height, block& blk)
 {
+    if (block_cache->get_block(height, blk))
+        return true;
     
     auto future_result = thread_pool->submit(
             [this](auto height, auto& blk) 
@@ -143,13 +306,293 @@ CurrentBlockchainStatus::get_block(uint64_t height, block& blk)
                            ->get_block_from_height(height, blk);
             }, height, std::ref(blk));
 
-    return future_result.get();
+    if (!future_result.get())
+        return false;
+
+    block_cache->put_block(height, blk);
+
+    return true;
+}
+
+void
+CurrentBlockchainStatus::check_block_cache_for_reorg()
+{
+    // reorgs replace top blocks only, so its enough to
+    // check the top cached blocks, until we find one that is
+    // still in the blockchain. 
+    static constexpr size_t max_blocks_to_check {100};
+
+    uint64_t top_height = current_height;
+
+    // top blocks could have been just popped
+    block_cache->invalidate_from(top_height + 1);
+
+    for (uint64_t height: block_cache->get_top_heights(max_blocks_to_check))
+    {
+        crypto::hash cached_hash;
+
+        if (!block_cache->get_block_hash(height, cached_hash))
+            continue;
+
+        // dont use get_block here, as it would
+        // return the cached block
+        block blk;
+
+        auto future_result = thread_pool->submit(
+                [this](auto height, auto& blk) 
+                    -> bool 
+                {
+                    return this->mcore
+                               ->get_block_from_height(height, blk);
+                }, height, std::ref(blk));
+
+        if (future_result.get() && get_block_hash(blk) == cached_hash)
+            break;
+
+        OMWARN << "Block " << height << " in the block cache "
+                  "is not in the blockchain anymore. Removing it.";
+
+        block_cache->invalidate_from(height);
+
+        // windows prefetched from the cache can have it too
+        block_scanner->invalidate_from(height);
+    }
+}
+
+bool
+CurrentBlockchainStatus::find_valid_indexed_height(
+        uint64_t indexed_height,
+        std::function<bool(uint64_t, crypto::hash&)> get_indexed_hash,
+        uint64_t& valid_height)
+{
+    // go back until we find a block that is still in the blockchain.
+    // usually its the first one we check.
+    valid_height = indexed_height;
+
+    while (valid_height > 0)
+    {
+        crypto::hash indexed_hash;
+        block blk;
+
+        if (!get_indexed_hash(valid_height - 1, indexed_hash))
+            break;
+
+        if (valid_height - 1 <= current_height)
+        {
+            // dont remove anything if we just cant read the block
+            if (!get_block(valid_height - 1, blk))
+                return false;
+
+            if (get_block_hash(blk) == indexed_hash)
+                break;
+        }
+
+        --valid_height;
+    }
+
+    return true;
+}
+
+bool
+CurrentBlockchainStatus::update_ring_member_index()
+{
+    if (!ring_member_index)
+        return false;
+
+    uint64_t indexed_height = ring_member_index->get_indexed_height();
+
+    uint64_t valid_height;
+
+    if (!find_valid_indexed_height(
+                indexed_height,
+                [this](uint64_t height, crypto::hash& blk_hash)
+                {
+                    return ring_member_index->get_block_hash(height,
+                                                             blk_hash);
+                },
+                valid_height))
+        return false;
+
+    if (valid_height < indexed_height)
+    {
+        OMWARN << "Removing blocks from " << valid_height
+               << " from ring member index due to reorganization";
+
+        ring_member_index->pop_blocks(valid_height);
+    }
+
+    if (valid_height > current_height)
+        return false;
+
+    uint64_t h1 = valid_height;
+    uint64_t h2 = std::min(h1 + bc_setup.ring_member_index_blocks_per_batch - 1,
+                           current_height.load());
+
+    // these are mostly old blocks, so they are not put into
+    // block_cache, where they would evict blocks being scanned
+    vector<block> blocks = get_blocks_range(h1, h2, false);
+
+    if (blocks.empty())
+        return false;
+
+    vector<crypto::hash> txs_hashes;
+    vector<transaction> txs;
+    vector<txs_tuple_t> txs_data;
+
+    if (!get_txs_in_blocks(blocks, txs_hashes, txs, txs_data, false))
+        return false;
+
+    // txs are in block order, so just go over them block by block
+    size_t tx_idx {0};
+
+    for (size_t blk_i = 0; blk_i < blocks.size(); ++blk_i)
+    {
+        size_t no_of_txs = blocks[blk_i].tx_hashes.size() + 1;
+
+        vector<transaction> blk_txs(txs.begin() + tx_idx,
+                                    txs.begin() + tx_idx + no_of_txs);
+
+        tx_idx += no_of_txs;
+
+        if (!ring_member_index->add_block(h1 + blk_i,
+                                          get_block_hash(blocks[blk_i]),
+                                          blk_txs))
+        {
+            OMERROR << "Cant add block " << h1 + blk_i
+                    << " to ring member index";
+            return false;
+        }
+    }
+
+    ring_member_index->flush();
+
+    OMVLOG1 << "Ring member index at height "
+            << ring_member_index->get_indexed_height();
+
+    return true;
+}
+
+void
+CurrentBlockchainStatus::build_ring_member_index()
+{
+    while (!stop_blockchain_monitor_loop)
+    {
+        // sleep only when there is nothing more to add,
+        // or we failed to add it
+        if (!update_ring_member_index())
+            wait_for_monitor_loop(bc_setup.blockchain_height_poll_every);
+    }
+
+    OMINFO << "Exiting ring member index thread.";
+}
+
+bool
+CurrentBlockchainStatus::update_scan_digest()
+{
+    if (!scan_digest)
+        return false;
+
+    uint64_t digest_height = scan_digest->get_height();
+
+    uint64_t valid_height;
+
+    if (!find_valid_indexed_height(
+                digest_height,
+                [this](uint64_t height, crypto::hash& blk_hash)
+                {
+                    return scan_digest->get_block_hash(height, blk_hash);
+                },
+                valid_height))
+        return false;
+
+    if (valid_height < digest_height)
+    {
+        OMWARN << "Removing blocks from " << valid_height
+               << " from scan digest due to reorganization";
+
+        scan_digest->pop_blocks(valid_height);
+
+        // windows can be prefetched from the digest
+        block_scanner->invalidate_from(valid_height);
+    }
+
+    if (valid_height > current_height)
+        return false;
+
+    uint64_t h1 = valid_height;
+    uint64_t h2 = std::min(h1 + bc_setup.scan_digest_blocks_per_batch - 1,
+                           current_height.load());
+
+    // not cached, same as in update_ring_member_index
+    vector<block> blocks = get_blocks_range(h1, h2, false);
+
+    if (blocks.empty())
+        return false;
+
+    vector<crypto::hash> txs_hashes;
+    vector<transaction> txs;
+    vector<txs_tuple_t> txs_data;
+
+    if (!get_txs_in_blocks(blocks, txs_hashes, txs, txs_data, false))
+        return false;
+
+    size_t tx_idx {0};
+
+    for (size_t blk_i = 0; blk_i < blocks.size(); ++blk_i)
+    {
+        size_t no_of_txs = blocks[blk_i].tx_hashes.size() + 1;
+
+        vector<crypto::hash> blk_txs_hashes(
+                    txs_hashes.begin() + tx_idx,
+                    txs_hashes.begin() + tx_idx + no_of_txs);
+
+        vector<transaction> blk_txs(txs.begin() + tx_idx,
+                                    txs.begin() + tx_idx + no_of_txs);
+
+        tx_idx += no_of_txs;
+
+        if (!scan_digest->add_block(h1 + blk_i,
+                                    get_block_hash(blocks[blk_i]),
+                                    blocks[blk_i].timestamp,
+                                    blk_txs_hashes,
+                                    blk_txs))
+        {
+            OMERROR << "Cant add block " << h1 + blk_i
+                    << " to scan digest";
+            return false;
+        }
+    }
+
+    scan_digest->flush();
+
+    OMVLOG1 << "Scan digest at height " << scan_digest->get_height();
+
+    return true;
+}
+
+void
+CurrentBlockchainStatus::build_scan_digest()
+{
+    while (!stop_blockchain_monitor_loop)
+    {
+        // sleep only when there is nothing more to add,
+        // or we failed to add it
+        if (!update_scan_digest())
+            wait_for_monitor_loop(bc_setup.blockchain_height_poll_every);
+    }
+
+    OMINFO << "Exiting scan digest thread.";
 }
 
 vector<block>
 CurrentBlockchainStatus::get_blocks_range(
-        uint64_t const& h1, uint64_t const& h2)
+        uint64_t const& h1, uint64_t const& h2, bool use_cache)
 {
+    vector<block> blocks;
+
+    if (use_cache && block_cache->get_blocks(h1, h2, blocks))
+        return blocks;
+
     auto future_result = thread_pool->submit(
             [this](auto h1, auto h2) 
                 -> vector<block>
@@ -165,7 +608,15 @@ CurrentBlockchainStatus::get_blocks_range(
                 }
             }, h1, h2);
 
-    return future_result.get();
+    blocks = future_result.get();
+
+    if (!use_cache)
+        return blocks;
+
+    for (size_t i = 0; i < blocks.size(); ++i)
+        block_cache->put_block(h1 + i, blocks[i]);
+
+    return blocks;
 }
 
 bool
@@ -206,8 +657,33 @@ bool
 CurrentBlockchainStatus::get_txs(
         vector<crypto::hash> const& txs_to_get,
         vector<transaction>& txs,
-        vector<crypto::hash>& missed_txs)
+        vector<crypto::hash>& missed_txs,
+        bool use_cache)
 {
+    // first check which txs we already have in the cache.
+    // only the remaining ones are fetched from lmdb
+    vector<transaction> cached_txs(txs_to_get.size());
+    vector<bool> is_cached(txs_to_get.size(), false);
+
+    vector<crypto::hash> not_cached_txs;
+
+    for (size_t i = 0; i < txs_to_get.size(); ++i)
+    {
+        if (use_cache && block_cache->get_tx(txs_to_get[i], cached_txs[i]))
+            is_cached[i] = true;
+        else
+            not_cached_txs.push_back(txs_to_get[i]);
+    }
+
+    if (!txs_to_get.empty() && not_cached_txs.empty())
+    {
+        std::move(cached_txs.begin(), cached_txs.end(),
+                  std::back_inserter(txs));
+        return true;
+    }
+
+    vector<transaction> fetched_txs;
+    vector<crypto::hash> fetched_missed_txs;
 
     auto future_result = thread_pool->submit(
             [this](auto const& txs_to_get, 
@@ -224,10 +700,40 @@ CurrentBlockchainStatus::get_txs(
 
                 return true;
 
-            }, std::cref(txs_to_get), std::ref(txs), 
-               std::ref(missed_txs));
+            }, std::cref(not_cached_txs), std::ref(fetched_txs), 
+               std::ref(fetched_missed_txs));
 
-    return future_result.get();
+    if (!future_result.get())
+        return false;
+
+    // merge cached and fetched txs keeping the order
+    // of txs_to_get. missed txs are not returned, same as
+    // mcore->get_transactions does.
+    unordered_set<crypto::hash> missed_set(fetched_missed_txs.begin(),
+                                           fetched_missed_txs.end());
+
+    size_t fetched_idx {0};
+
+    for (size_t i = 0; i < txs_to_get.size(); ++i)
+    {
+        if (is_cached[i])
+        {
+            txs.push_back(std::move(cached_txs[i]));
+            continue;
+        }
+
+        if (missed_set.count(txs_to_get[i]))
+            continue;
+
+        if (fetched_idx < fetched_txs.size())
+            txs.push_back(std::move(fetched_txs[fetched_idx++]));
+    }
+
+    missed_txs.insert(missed_txs.end(),
+                      fetched_missed_txs.begin(),
+                      fetched_missed_txs.end());
+
+    return true;
 }
 
 bool
@@ -586,64 +1092,232 @@ CurrentBlockchainStatus::commit_tx(
     return true;
 }
 
+bool
+CurrentBlockchainStatus::get_txpool_hashes(
+        vector<pair<crypto::hash, uint64_t>>& pool_hashes)
+{
+    pool_hashes.clear();
+
+    return mcore->get_core().for_all_txpool_txes(
+            [&pool_hashes](crypto::hash const& tx_hash,
+                           txpool_tx_meta_t const& meta,
+                           cryptonote::blobdata const*)
+            {
+                pool_hashes.emplace_back(tx_hash, meta.receive_time);
+                return true;
+            });
+}
+
+bool
+CurrentBlockchainStatus::get_txpool_tx_blob(
+        crypto::hash const& tx_hash,
+        cryptonote::blobdata& tx_blob)
+{
+    return mcore->get_core().get_txpool_tx_blob(tx_hash, tx_blob);
+}
+
 bool
 CurrentBlockchainStatus::read_mempool()
 {
-    // get txs in the mempool
+    // only hashes and receive times of txs in the mempool are
+    // read every time. txs themselves are read and deserialized
+    // only when we see them for the first time
+    using pool_hashes_t = vector<pair<crypto::hash, uint64_t>>;
 
-    mempool_txs_t local_mempool_txs;
-    
-    auto future_result = thread_pool->submit(
-        [this](auto& local_mempool_txs)
-            -> bool 
+    pool_hashes_t pool_hashes;
+
+    auto future_hashes = thread_pool->submit(
+        [this](auto& pool_hashes)
+            -> bool
         {
+            return this->get_txpool_hashes(pool_hashes);
+        }, std::ref(pool_hashes));
 
-            std::vector<transaction> txs;
+    if (!future_hashes.get())
+    {
+        OMERROR << "Getting mempool failed ";
+        return false;
+    }
 
-            if (!this->mcore->get_mempool_txs(txs))
-            {
-                OMERROR << "Getting mempool failed ";
-                return false;
-            }
+    // mempool_snapshot is published only here, in
+    // the monitor thread
+    auto old_snapshot = get_mempool_snapshot();
 
-            for (size_t i = 0; i < txs.size(); ++i)
-            {
-                // get transaction info of the tx in the mempool
-                auto const& tx = txs.at(i);
+    pool_hashes_t new_hashes;
 
-                tx_memory_pool::tx_details txd;
+    for (auto const& h: pool_hashes)
+        if (old_snapshot->txs_by_hash.count(h.first) == 0)
+            new_hashes.push_back(h);
 
-                txpool_tx_meta_t meta;
+    vector<shared_ptr<MempoolTx const>> new_txs;
 
-                if (!this->mcore->get_core().get_txpool_tx_meta(tx.hash, meta))
+    if (!new_hashes.empty())
+    {
+        auto future_txs = thread_pool->submit(
+            [this](auto const& new_hashes, auto& new_txs)
+                -> bool
+            {
+                for (auto const& h: new_hashes)
                 {
-                  OMERROR << "Failed to find tx in txpool";
-                  return false;
+                    cryptonote::blobdata tx_blob;
+
+                    // tx could have left the mempool in the meantime
+                    if (!this->get_txpool_tx_blob(h.first, tx_blob))
+                        continue;
+
+                    auto mtx = make_shared<MempoolTx>();
+
+                    mtx->receive_time = h.second;
+                    mtx->tx_hash = h.first;
+
+                    if (!parse_and_validate_tx_from_blob(tx_blob, mtx->tx))
+                    {
+                        OMERROR << "Cant parse tx from mempool: "
+                                << pod_to_hex(h.first);
+                        continue;
+                    }
+
+                    for (auto const& in_key: xmreg::get_key_images(mtx->tx))
+                        mtx->key_images.push_back(in_key.k_image);
+
+                    new_txs.push_back(mtx);
                 }
 
-                local_mempool_txs.emplace_back(meta.receive_time, tx);
+                return true;
 
-            } // for (size_t i = 0; i < mempool_tx_info.size(); ++i)
+            }, std::cref(new_hashes), std::ref(new_txs));
 
-            return true;
+        future_txs.get();
+    }
 
-        }, std::ref(local_mempool_txs));
+    std::unordered_set<crypto::hash> in_pool;
 
-    if (!future_result.get())
-        return false;
+    for (auto const& h: pool_hashes)
+        in_pool.insert(h.first);
+
+    size_t no_of_removed {0};
+
+    for (auto const& kv: old_snapshot->txs_by_hash)
+        if (in_pool.count(kv.first) == 0)
+            ++no_of_removed;
+
+    if (no_of_removed == 0 && new_txs.empty())
+        return true;
 
-    std::lock_guard<std::mutex> lck (getting_mempool_txs);
+    OMVLOG2 << "Mempool: " << new_txs.size() << " new txs, "
+            << no_of_removed << " removed";
 
-    mempool_txs = std::move(local_mempool_txs);
+    // new snapshot shares txs with the old one, so only
+    // pointers to them are copied
+    auto snapshot = make_shared<MempoolSnapshot>();
+
+    snapshot->txs.reserve(old_snapshot->txs.size()
+                          - no_of_removed + new_txs.size());
+
+    for (auto const& mtx: old_snapshot->txs)
+        if (in_pool.count(mtx->tx_hash) > 0)
+            snapshot->txs.push_back(mtx);
+
+    snapshot->txs.insert(snapshot->txs.end(),
+                         new_txs.begin(), new_txs.end());
+
+    std::sort(snapshot->txs.begin(), snapshot->txs.end(),
+              [](auto const& l, auto const& r)
+              {
+                  return l->receive_time < r->receive_time;
+              });
+
+    for (auto const& mtx: snapshot->txs)
+    {
+        snapshot->txs_by_hash[mtx->tx_hash] = mtx;
+
+        for (auto const& k_image: mtx->key_images)
+            snapshot->key_images[k_image] = mtx->tx_hash;
+    }
+
+    std::atomic_store(&mempool_snapshot,
+                      shared_ptr<MempoolSnapshot const> {std::move(snapshot)});
+
+    ++mempool_version;
 
     return true;
 }
 
+void
+CurrentBlockchainStatus::update_mempool_txs_of_accounts()
+{
+    auto snapshot = get_mempool_snapshot();
+
+    vector<shared_ptr<TxSearch>> tx_searches;
+
+    {
+        std::lock_guard<std::mutex> lck (searching_threads_map_mtx);
+
+        for (auto const& st: searching_threads)
+            tx_searches.push_back(st.second);
+    }
+
+    // each new tx is identified once per account here, rather
+    // than on every get_address_txs request of the account
+    for (auto const& tx_search: tx_searches)
+    {
+        try
+        {
+            tx_search->update_mempool_txs(snapshot->txs);
+        }
+        catch (std::exception const& e)
+        {
+            OMERROR << "Cant identify mempool txs: " << e.what();
+        }
+    }
+}
+
+void
+CurrentBlockchainStatus::identify_mempool_txs()
+{
+    while (true)
+    {
+        {
+            std::unique_lock<std::mutex> lck (monitor_mtx);
+
+            monitor_cv.wait(lck, [this]()
+            {
+                return stop_blockchain_monitor_loop || mempool_changed;
+            });
+
+            if (stop_blockchain_monitor_loop)
+                break;
+
+            // changes made while we identify txs will
+            // be handled in the next iteration
+            mempool_changed = false;
+        }
+
+        update_mempool_txs_of_accounts();
+    }
+
+    OMINFO << "Exiting mempool identification thread.";
+}
+
 CurrentBlockchainStatus::mempool_txs_t
 CurrentBlockchainStatus::get_mempool_txs()
 {
-    std::lock_guard<std::mutex> lck (getting_mempool_txs);
-    return mempool_txs;
+    auto snapshot = get_mempool_snapshot();
+
+    mempool_txs_t local_mempool_txs;
+
+    local_mempool_txs.reserve(snapshot->txs.size());
+
+    for (auto const& mtx: snapshot->txs)
+        local_mempool_txs.emplace_back(mtx->receive_time, mtx->tx);
+
+    return local_mempool_txs;
+}
+
+shared_ptr<CurrentBlockchainStatus::MempoolSnapshot const>
+CurrentBlockchainStatus::get_mempool_snapshot() const
+{
+    return std::atomic_load(&mempool_snapshot);
 }
 
 //@todo search_if_payment_made is way too long!
@@ -805,10 +1479,13 @@ CurrentBlockchainStatus::start_tx_search_thread(
         // launch SearchTx thread for the given xmr account
 
         searching_threads.insert(
-            {acc.address, ThreadRAII2<TxSearch>(std::move(tx_search))});
+            {acc.address, shared_ptr<TxSearch>(std::move(tx_search))});
 
         OMINFO << acc.address.substr(0,6)
                   + ": TxSearch thread created.";
+
+        // let the scanner know that it has new account to scan
+        block_scanner->wake_up();
     }
     catch (const std::exception& e)
     {
@@ -859,6 +1536,20 @@ CurrentBlockchainStatus::get_searched_blk_no(const string& address,
     return true;
 }
 
+bool
+CurrentBlockchainStatus::get_account_state_version(const string& address,
+                                                   uint64_t& state_version)
+{
+    std::lock_guard<std::mutex> lck (searching_threads_map_mtx);
+
+    if (!search_thread_exist(address))
+        return false;
+
+    state_version = get_search_thread(address).get_state_version();
+
+    return true;
+}
+
 bool
 CurrentBlockchainStatus::get_known_outputs_keys(
         string const& address,
@@ -931,18 +1622,29 @@ CurrentBlockchainStatus::find_txs_in_mempool(
         const string& address_str,
         json& transactions)
 {
-    std::lock_guard<std::mutex> lck (getting_mempool_txs);
+    auto snapshot = get_mempool_snapshot();
+
+    shared_ptr<TxSearch> tx_search;
 
-    if (searching_threads.count(address_str) == 0)
     {
-        // thread does not exist
-        OMERROR << "thread for "
-                << address_str.substr(0,6) << " does not exist";
-        return false;
+        std::lock_guard<std::mutex> lck (searching_threads_map_mtx);
+
+        auto it = searching_threads.find(address_str);
+
+        if (it == searching_threads.end())
+        {
+            // thread does not exist
+            OMERROR << "thread for "
+                    << address_str.substr(0,6) << " does not exist";
+            return false;
+        }
+
+        tx_search = it->second;
     }
 
-    get_search_thread(address_str)
-            .find_txs_in_mempool(mempool_txs, &transactions);
+    // identification is done without holding any of our
+    // mutexes, so other requests are not blocked by it
+    tx_search->find_txs_in_mempool(snapshot->txs, &transactions);
 
     return true;
 }
@@ -952,33 +1654,40 @@ CurrentBlockchainStatus::find_tx_in_mempool(
         crypto::hash const& tx_hash,
         transaction& tx)
 {
+    auto mtx = find_mempool_tx(tx_hash);
 
-    std::lock_guard<std::mutex> lck (getting_mempool_txs);
+    if (!mtx)
+        return false;
 
-    for (auto const& mtx: mempool_txs)
-    {
-        const transaction &m_tx = mtx.second;
+    tx = mtx->tx;
 
-        if (get_transaction_hash(m_tx) == tx_hash)
-        {
-            tx = m_tx;
-            return true;
-        }
-    }
+    return true;
+}
 
-    return false;
+shared_ptr<MempoolTx const>
+CurrentBlockchainStatus::find_mempool_tx(crypto::hash const& tx_hash)
+{
+    auto snapshot = get_mempool_snapshot();
+
+    auto it = snapshot->txs_by_hash.find(tx_hash);
+
+    if (it == snapshot->txs_by_hash.end())
+        return nullptr;
+
+    return it->second;
 }
 
 bool
 CurrentBlockchainStatus::find_key_images_in_mempool(
         std::vector<txin_v> const& vin)
 {
-    std::lock_guard<std::mutex> lck (getting_mempool_txs);
-
-    // perform exhostive search to check if any key image in vin vector
-    // is in the mempool. This is used to check if a tx generated
-    // by the frontend
+    // check if any key image in vin vector is in the mempool.
+    // This is used to check if a tx generated by the frontend
     // is using any key images that area already in the mempool.
+    // key images are indexed when txs enter our mirror of
+    // the mempool, so we dont need to go through all its txs
+    auto snapshot = get_mempool_snapshot();
+
     for (auto const& kin: vin)
     {
         if(kin.type() != typeid(txin_to_key))
@@ -988,20 +1697,9 @@ CurrentBlockchainStatus::find_key_images_in_mempool(
         const txin_to_key& tx_in_to_key
                 = boost::get<cryptonote::txin_to_key>(kin);
 
-        for (auto const& mtx: mempool_txs)
-        {
-            transaction const& m_tx = mtx.second;
-
-            vector<txin_to_key> input_key_imgs
-                    = xmreg::get_key_images(m_tx);
-
-            for (auto const& mki: input_key_imgs)
-            {
-                // if a matching key image found in the mempool
-                if (mki.k_image == tx_in_to_key.k_image)
-                    return true;
-            }
-        }
+        // if a matching key image found in the mempool
+        if (snapshot->key_images.count(tx_in_to_key.k_image) > 0)
+            return true;
     }
 
     return false;
@@ -1021,6 +1719,9 @@ CurrentBlockchainStatus::get_tx(
         crypto::hash const& tx_hash,
         transaction& tx)
 {
+    if (block_cache->get_tx(tx_hash, tx))
+        return true;
+
     auto future_result = thread_pool->submit(
             [this](auto const& tx_hash,
                    auto& tx) -> bool
@@ -1084,6 +1785,8 @@ CurrentBlockchainStatus::set_new_searched_blk_no(
 
     get_search_thread(address).set_searched_blk_no(new_value);
 
+    block_scanner->wake_up();
+
     return true;
 }
 
@@ -1126,7 +1829,22 @@ CurrentBlockchainStatus::get_search_thread(string const& acc_address)
                                  "non-existing search thread");
     }
 
-    return searching_threads.find(acc_address)->second.get_functor();
+    return *(it->second);
+}
+
+vector<shared_ptr<TxSearch>>
+CurrentBlockchainStatus::get_search_threads()
+{
+    std::lock_guard<std::mutex> lck (searching_threads_map_mtx);
+
+    vector<shared_ptr<TxSearch>> searches;
+
+    searches.reserve(searching_threads.size());
+
+    for (auto const& st: searching_threads)
+        searches.push_back(st.second);
+
+    return searches;
 }
 
 size_t
@@ -1147,13 +1865,13 @@ CurrentBlockchainStatus::clean_search_thread_map()
         auto& st = *it;
 
         if (search_thread_exist(st.first)
-                && st.second.get_functor().still_searching() == false)
+                && st.second->still_searching() == false)
         {
             // before erasing a search thread, check if there was any
             // exception thrown by it
             try
             {
-                auto eptr = st.second.get_functor().get_exception_ptr();
+                auto eptr = st.second->get_exception_ptr();
                 if (eptr != nullptr)
                     std::rethrow_exception(eptr);
             }
@@ -1180,7 +1898,7 @@ CurrentBlockchainStatus::stop_search_threads()
 
     for (auto& st: searching_threads)
     {
-        st.second.get_functor().stop();
+        st.second->stop();
     }
 }
 
@@ -1320,7 +2038,8 @@ CurrentBlockchainStatus::get_txs_in_blocks(
         vector<block> const& blocks,
         vector<crypto::hash>& txs_hashes,
         vector<transaction>& txs,
-        vector<txs_tuple_t>& txs_data)
+        vector<txs_tuple_t>& txs_data,
+        bool use_cache)
 {
 
     // initialize vectors of txs hashes, block heights
@@ -1331,7 +2050,8 @@ CurrentBlockchainStatus::get_txs_in_blocks(
     // analyzing in this iteration
     vector<crypto::hash> missed_txs;
 
-    if (!CurrentBlockchainStatus::get_txs(txs_hashes, txs, missed_txs)
+    if (!CurrentBlockchainStatus::get_txs(txs_hashes, txs, missed_txs,
+                                          use_cache)
             || !missed_txs.empty()
             || (txs_hashes.size() != txs.size()))
     {
@@ -1341,9 +2061,85 @@ CurrentBlockchainStatus::get_txs_in_blocks(
 
     (void) missed_txs;
 
+    if (!use_cache)
+        return true;
+
+    // keep the txs in the cache with their blocks,
+    // so that next scans of these blocks dont need lmdb.
+    // txs_hashes, txs and txs_data are in block order
+    // with miner tx first, as set in init_txs_data_vector
+    size_t tx_idx {0};
+
+    uint64_t h1 = get_block_height(blocks[0]);
+
+    for (size_t blk_i = 0; blk_i < blocks.size(); ++blk_i)
+    {
+        block const& blk = blocks[blk_i];
+
+        size_t no_of_txs = blk.tx_hashes.size() + 1;
+
+        vector<crypto::hash> blk_txs_hashes(
+                txs_hashes.begin() + tx_idx,
+                txs_hashes.begin() + tx_idx + no_of_txs);
+
+        vector<transaction> blk_txs(
+                txs.begin() + tx_idx,
+                txs.begin() + tx_idx + no_of_txs);
+
+        block_cache->put_block_txs(h1 + blk_i, blk,
+                                   blk_txs_hashes, blk_txs);
+
+        tx_idx += no_of_txs;
+    }
+
     return true;
 }
 
+shared_ptr<ScanWindow>
+CurrentBlockchainStatus::get_scan_window(uint64_t h1, uint64_t h2)
+{
+    // use the digest for as many blocks as it has. the scanner
+    // asks for the rest in its next window
+    if (scan_digest)
+    {
+        uint64_t digest_height = scan_digest->get_height();
+
+        if (h1 < digest_height)
+        {
+            auto window = make_shared<ScanWindow>();
+
+            if (scan_digest->get_window(h1, std::min(h2, digest_height - 1),
+                                        *window))
+                return window;
+        }
+    }
+
+    vector<block> blocks = get_blocks_range(h1, h2);
+
+    if (blocks.empty())
+    {
+        OMERROR << "Cant get blocks from " << h1 << " to " << h2;
+        return nullptr;
+    }
+
+    auto window = make_shared<ScanWindow>();
+
+    window->h1 = h1;
+    window->h2 = h1 + blocks.size() - 1;
+    window->last_block_timestamp = blocks.back().timestamp;
+
+    if (!get_txs_in_blocks(blocks,
+                           window->txs_hashes,
+                           window->txs,
+                           window->txs_data))
+    {
+        OMERROR << "Cant get tx in blocks from " << h1 << " to " << h2;
+        return nullptr;
+    }
+
+    return window;
+}
+
 
 
     
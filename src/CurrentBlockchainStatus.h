@@ -8,6 +8,11 @@
 #include "TxUnlockChecker.h"
 #include "BlockchainSetup.h"
 #include "TxSearch.h"
+#include "BlockScanner.h"
+#include "BlockCache.h"
+#include "RingMemberIndex.h"
+#include "ScanDigest.h"
+#include "DbWriter.h"
 #include "utils.h"
 #include "ThreadRAII.h"
 #include "RPCCalls.h"
@@ -21,6 +26,9 @@
 #include <thread>
 #include <mutex>
 #include <atomic>
+#include <unordered_set>
+#include <unordered_map>
+#include <condition_variable>
 
 
 namespace xmreg {
@@ -30,6 +38,7 @@ using namespace std;
 class XmrAccount;
 class MySqlAccounts;
 class TxSearch;
+class BlockScanner;
 
 /*
 * This is a thread class. Probably it should be singleton, as we want
@@ -51,6 +60,20 @@ public:
     using mempool_txs_t = vector<pair<uint64_t, transaction>>;
 
 
+    // txs in the mempool at some point in time. readers
+    // can keep using it without any locks for as long
+    // as they need, even after the mempool changed
+    struct MempoolSnapshot
+    {
+        // sorted by receive time
+        TxSearch::pool_txs_t txs;
+
+        unordered_map<crypto::hash, shared_ptr<MempoolTx const>> txs_by_hash;
+
+        // key images of all inputs and txs they are in
+        unordered_map<key_image, crypto::hash> key_images;
+    };
+
     //              height , timestamp, is_coinbase
     using txs_tuple_t
         = std::tuple<uint64_t, uint64_t, bool>;
@@ -90,11 +113,71 @@ public:
                    TxUnlockChecker const& tx_unlock_checker
                         = TxUnlockChecker());
 
+    // unlock_time limits matching is_tx_unlocked,
+    // for the current height
+    virtual UnlockLimits
+    get_unlock_limits(TxUnlockChecker const& tx_unlock_checker
+                        = TxUnlockChecker());
+
     virtual bool
     get_block(uint64_t height, block &blk);
 
+    // drops cached blocks which are no longer
+    // in the blockchain due to reorganization
+    virtual void
+    check_block_cache_for_reorg();
+
+    // adds next batch of blocks to the ring member index, after
+    // removing blocks that got reorganized. returns false if
+    // nothing was added
+    virtual bool
+    update_ring_member_index();
+
+    // keeps calling update_ring_member_index until stop()
+    // is called. executed in its own thread
+    virtual void
+    build_ring_member_index();
+
+    // nullptr if the index is not used
+    virtual RingMemberIndex*
+    get_ring_member_index()
+    {
+        return ring_member_index.get();
+    }
+
+    // writes results of all TxSearch objects into mysql
+    virtual DbWriter*
+    get_db_writer()
+    {
+        return db_writer.get();
+    }
+
+    // identifies new mempool txs for all accounts being searched,
+    // so that find_txs_in_mempool only merges their results
+    virtual void
+    update_mempool_txs_of_accounts();
+
+    // calls update_mempool_txs_of_accounts whenever read_mempool
+    // found changes, until stop() is called. executed in its own
+    // thread, so that monitor_blockchain does not wait for mysql
+    virtual void
+    identify_mempool_txs();
+
+    // adds next batch of blocks to the scan digest, after removing
+    // blocks that got reorganized. returns false if nothing was added
+    virtual bool
+    update_scan_digest();
+
+    // keeps calling update_scan_digest until stop() is called.
+    // executed in its own thread
+    virtual void
+    build_scan_digest();
+
+    // with use_cache false, block_cache is neither used nor
+    // updated. used for reading whole blockchain in the background
     virtual vector<block>
-    get_blocks_range(uint64_t const& h1, uint64_t const& h2);
+    get_blocks_range(uint64_t const& h1, uint64_t const& h2,
+                     bool use_cache = true);
 
     virtual bool
     get_block_txs(const block &blk,
@@ -104,7 +187,8 @@ public:
     virtual bool
     get_txs(vector<crypto::hash> const& txs_to_get,
             vector<transaction>& txs,
-            vector<crypto::hash>& missed_txs);
+            vector<crypto::hash>& missed_txs,
+            bool use_cache = true);
 
     virtual bool
     tx_exist(const crypto::hash& tx_hash);
@@ -182,12 +266,44 @@ public:
     commit_tx(const string& tx_blob, string& error_msg,
               bool do_not_relay = false);
 
+    // hashes and receive times of txs in the txpool. MicroCore
+    // gives access to the txpool only through its core, which
+    // cant be mocked in tests, so its wrapped here
+    virtual bool
+    get_txpool_hashes(vector<pair<crypto::hash, uint64_t>>& pool_hashes);
+
+    // false if the tx is no longer in the txpool
+    virtual bool
+    get_txpool_tx_blob(crypto::hash const& tx_hash,
+                       cryptonote::blobdata& tx_blob);
+
     virtual bool
     read_mempool();
 
+    // copies all txs. get_mempool_snapshot should
+    // be used when only reading them
     virtual vector<pair<uint64_t, transaction>>
     get_mempool_txs();
 
+    // never nullptr
+    virtual shared_ptr<MempoolSnapshot const>
+    get_mempool_snapshot() const;
+
+    // increases every time txs in the mempool change
+    virtual uint64_t
+    get_mempool_version() const
+    {
+        return mempool_version;
+    }
+
+    // different after every restart, when mempool_version starts
+    // again from 0. so clients can tell their cursors are stale
+    virtual uint64_t
+    get_service_epoch() const
+    {
+        return service_epoch;
+    }
+
     virtual bool
     search_if_payment_made(
             const string& payment_id_str,
@@ -229,6 +345,11 @@ public:
     find_tx_in_mempool(crypto::hash const& tx_hash,
                        transaction& tx);
 
+    // tx in the mempool with its receive time, or nullptr.
+    // the returned tx stays valid after it leaves the mempool
+    virtual shared_ptr<MempoolTx const>
+    find_mempool_tx(crypto::hash const& tx_hash);
+
     virtual bool
     find_key_images_in_mempool(std::vector<txin_v> const& vin);
 
@@ -257,6 +378,11 @@ public:
     get_searched_blk_no(const string& address,
                         uint64_t& searched_blk_no);
 
+    // see TxSearch::state_version
+    virtual bool
+    get_account_state_version(const string& address,
+                              uint64_t& state_version);
+
     virtual bool
     get_known_outputs_keys(string const& address,
                            unordered_map<public_key, 
@@ -302,13 +428,27 @@ public:
     get_txs_in_blocks(vector<block> const& blocks,
                       vector<crypto::hash>& txs_hashes,
                       vector<transaction>& txs,
-                      vector<txs_tuple_t>& txs_data);
+                      vector<txs_tuple_t>& txs_data,
+                      bool use_cache = true);
+
+    // reads blocks from h1 to h2 and all their txs.
+    // returns nullptr if it fails.
+    virtual shared_ptr<ScanWindow>
+    get_scan_window(uint64_t h1, uint64_t h2);
 
     virtual TxSearch&
     get_search_thread(string const& acc_address);
 
-    inline virtual void
-    stop() {stop_blockchain_monitor_loop = true;}
+    // copy of pointers to all TxSearch objects, so that
+    // BlockScanner can go over them without holding
+    // searching_threads_map_mtx
+    virtual vector<shared_ptr<TxSearch>>
+    get_search_threads();
+
+    // stops monitor_blockchain without waiting
+    // for its next iteration
+    virtual void
+    stop();
 
     // default destructor is fine
     virtual ~CurrentBlockchainStatus() = default;
@@ -345,15 +485,63 @@ protected:
     // the lmdb does not throw MDB_READERS_FULL 
     std::unique_ptr<TP::ThreadPool> thread_pool;
 
-    // vector of mempool transactions that all threads
-    // can refer to
-    //           <recieved_time, transaction>
-    mempool_txs_t mempool_txs;
+    // sleeps for the timeout or until stop() is called
+    virtual void
+    wait_for_monitor_loop(milliseconds timeout);
+
+    // monitor_blockchain sleeps on this between checking
+    // for new blocks, so that stop() can wake it up
+    mutex monitor_mtx;
+    condition_variable monitor_cv;
+
+    // set by monitor_blockchain when mempool changed, for
+    // identify_mempool_txs. guarded by monitor_mtx
+    bool mempool_changed {false};
+
+    // blocks and txs read through the thread_pool are kept here
+    // so that overlapping scans dont read them from lmdb again
+    std::unique_ptr<BlockCache> block_cache;
+
+    // ring members of all inputs in the blockchain. optional,
+    // used by TxSearch to find inputs of accounts faster
+    std::unique_ptr<RingMemberIndex> ring_member_index;
+
+    // pruned copy of the blockchain. optional, used by
+    // get_scan_window instead of lmdb when it has the blocks
+    std::unique_ptr<ScanDigest> scan_digest;
+
+    // group commits windows found by all TxSearch objects
+    std::unique_ptr<DbWriter> db_writer;
+
+    // finds height below which blocks in an index (ring member
+    // index or scan digest) are still in the blockchain. returns
+    // false if blocks to compare with could not be read
+    virtual bool
+    find_valid_indexed_height(
+            uint64_t indexed_height,
+            std::function<bool(uint64_t, crypto::hash&)> get_indexed_hash,
+            uint64_t& valid_height);
+
+    // current state of our mirror of the mempool. its never
+    // modified, read_mempool publishes a new one with std::atomic_store
+    // when the mempool changes. readers use get_mempool_snapshot
+    shared_ptr<MempoolSnapshot const> mempool_snapshot;
+
+    atomic<uint64_t> mempool_version {0};
+
+    // start time of the service in milliseconds
+    uint64_t service_epoch {0};
 
     // map that will keep track of search threads. In the
     // map, key is address to which a running thread belongs to.
     // make it static to guarantee only one such map exist.
-    map<string, ThreadRAII2<TxSearch>> searching_threads;
+    // TxSearch objects dont have their own threads anymore.
+    // they all are scanned by a single block_scanner.
+    map<string, shared_ptr<TxSearch>> searching_threads;
+
+    // scans blocks for all accounts in searching_threads.
+    // its thread is launched in monitor_blockchain
+    std::unique_ptr<BlockScanner> block_scanner;
 
     // thread that will be dispachaed and will keep monitoring blockchain
     // and mempool changes
@@ -362,8 +550,6 @@ protected:
     // to synchronize searching access to searching_threads map
     mutex searching_threads_map_mtx;
 
-    // to synchronize access to mempool_txs vector
-    mutex getting_mempool_txs;
 
 
     // have this method will make it easier to moc
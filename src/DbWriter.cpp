@@ -0,0 +1,334 @@
+#include "DbWriter.h"
+
+#include <algorithm>
+#include <unordered_map>
+
+namespace xmreg
+{
+
+DbWriter::DbWriter(size_t _max_queued)
+    : max_queued {std::max<size_t>(_max_queued, 1)},
+      xmr_accounts {make_shared<MySqlAccounts>(nullptr)}
+{
+    writer_thread = std::thread(&DbWriter::writer_loop, this);
+
+    OMINFO << "Mysql writer started with queue of "
+           << max_queued << " windows";
+}
+
+void
+DbWriter::write(shared_ptr<WindowWrite> window_write)
+{
+    std::future<void> committed;
+
+    {
+        std::unique_lock<std::mutex> lck (queue_mtx);
+
+        // backpressure. scanners wait here when mysql
+        // cant keep up with them
+        not_full_cv.wait(lck, [this]()
+                         {return done || queue.size() < max_queued;});
+
+        if (done)
+            throw DbWriterException("Mysql writer is stopped");
+
+        queue.push_back({std::move(window_write), {}});
+
+        committed = queue.back().committed.get_future();
+    }
+
+    queued_cv.notify_one();
+
+    committed.get();
+}
+
+void
+DbWriter::writer_loop()
+{
+    while (true)
+    {
+        deque<QueuedWrite> group;
+
+        {
+            std::unique_lock<std::mutex> lck (queue_mtx);
+
+            queued_cv.wait(lck, [this]() {return done || !queue.empty();});
+
+            // write all queued windows before quiting
+            if (queue.empty())
+                return;
+
+            // everything queued while the previous group
+            // was being committed goes into this one
+            group.swap(queue);
+        }
+
+        not_full_cv.notify_all();
+
+        commit_group(group);
+    }
+}
+
+void
+DbWriter::commit_group(deque<QueuedWrite>& group)
+{
+    std::exception_ptr eptr;
+
+    try
+    {
+        vector<WindowWrite*> windows;
+
+        for (auto& queued: group)
+            windows.push_back(queued.window_write.get());
+
+        commit_windows(windows);
+
+        for (auto& queued: group)
+            queued.committed.set_value();
+
+        return;
+    }
+    catch (std::exception const& e)
+    {
+        OMWARN << "Group commit of " << group.size()
+               << " windows failed: " << e.what();
+        eptr = std::current_exception();
+    }
+    catch (...)
+    {
+        OMWARN << "Group commit of " << group.size()
+               << " windows failed!";
+        eptr = std::current_exception();
+    }
+
+    if (group.size() == 1)
+    {
+        group.front().committed.set_exception(eptr);
+        return;
+    }
+
+    // write windows one by one, so that only
+    // the ones which cant be written fail
+    for (auto& queued: group)
+    {
+        try
+        {
+            commit_windows({queued.window_write.get()});
+
+            queued.committed.set_value();
+        }
+        catch (...)
+        {
+            queued.committed.set_exception(std::current_exception());
+        }
+    }
+}
+
+void
+DbWriter::commit_windows(vector<WindowWrite*> const& windows)
+{
+    auto conn = MySqlConnectionPool::get().grab_shared();
+
+    mysqlpp::Transaction mysql_transaction(*conn);
+
+    for (WindowWrite* window_write: windows)
+        write_window(*xmr_accounts, *window_write, conn);
+
+    mysql_transaction.commit();
+}
+
+void
+DbWriter::write_window(MySqlAccounts& xmr_accounts,
+                       WindowWrite& window_write,
+                       shared_ptr<mysqlpp::Connection> conn)
+{
+    uint64_t account_id = window_write.account_id;
+    uint64_t h1         = window_write.h1;
+    uint64_t h2         = window_write.h2;
+
+    auto const& txs_found = window_write.txs;
+
+    // window can be written again if its group failed,
+    // so we dont modify rows given to us
+    vector<XmrOutput> outputs_found = window_write.outputs;
+    vector<XmrInput> inputs_found   = window_write.inputs;
+
+    if (!txs_found.empty())
+    {
+        // when we rescan blockchain txs can already be present in
+        // the mysql. they are upserted, so their rows, and rows of
+        // their outputs and inputs, keep their ids and are not
+        // written again if nothing changed. txs of these blocks in
+        // mysql which are not found now are left as they are, same
+        // as for windows in which nothing is found
+        vector<XmrTransaction> txs_in_mysql;
+
+        xmr_accounts.select_txs_for_heights(account_id, h1, h2,
+                                            txs_in_mysql, conn);
+
+        unordered_map<string, uint64_t> tx_ids_by_hash;
+
+        for (auto const& tx_data: txs_found)
+            tx_ids_by_hash[tx_data.hash] = 0;
+
+        for (auto const& tx_row: txs_in_mysql)
+        {
+            auto it = tx_ids_by_hash.find(tx_row.hash);
+
+            if (it != tx_ids_by_hash.end())
+                it->second = tx_row.id.data;
+        }
+
+        // txs which were not in mysql before, by their index in
+        // txs_found. their rows, and rows of their outputs and
+        // inputs, can only be inserted. anything more written by
+        // upserts changes rows which clients may have already seen
+        vector<bool> is_new_tx;
+
+        for (auto const& tx_data: txs_found)
+            is_new_tx.push_back(tx_ids_by_hash[tx_data.hash] == 0);
+
+        uint64_t no_of_new_txs  = std::count(is_new_tx.begin(),
+                                             is_new_tx.end(), true);
+        uint64_t no_of_new_outs = 0;
+        uint64_t no_of_new_ins  = 0;
+
+        for (auto const& out_data: outputs_found)
+            no_of_new_outs += is_new_tx.at(out_data.tx_id);
+
+        for (auto const& in_data: inputs_found)
+            no_of_new_ins += is_new_tx.at(in_data.tx_id);
+
+        bool rows_changed {false};
+
+        uint64_t no_of_affected {0};
+
+        if (!xmr_accounts.upsert(txs_found, no_of_affected, conn))
+            throw DbWriterException("upsert txs_found failed in blocks "
+                                    + std::to_string(h1) + " to "
+                                    + std::to_string(h2));
+
+        rows_changed |= no_of_affected > no_of_new_txs;
+
+        if (no_of_new_txs > 0)
+        {
+            // get mysql ids of the new txs
+            xmr_accounts.select_txs_for_heights(account_id, h1, h2,
+                                                txs_in_mysql, conn);
+
+            for (auto const& tx_row: txs_in_mysql)
+            {
+                auto it = tx_ids_by_hash.find(tx_row.hash);
+
+                if (it != tx_ids_by_hash.end())
+                    it->second = tx_row.id.data;
+            }
+        }
+
+        vector<uint64_t> tx_mysql_ids;
+
+        for (auto const& tx_data: txs_found)
+        {
+            uint64_t tx_mysql_id = tx_ids_by_hash[tx_data.hash];
+
+            if (tx_mysql_id == 0)
+                throw DbWriterException("Cant find id of tx "
+                                        + tx_data.hash);
+
+            tx_mysql_ids.push_back(tx_mysql_id);
+        }
+
+        for (XmrOutput& out_data: outputs_found)
+            out_data.tx_id = tx_mysql_ids.at(out_data.tx_id);
+
+        for (XmrInput& in_data: inputs_found)
+            in_data.tx_id = tx_mysql_ids.at(in_data.tx_id);
+
+        if (!xmr_accounts.upsert(outputs_found, no_of_affected, conn))
+        {
+            OMERROR << "Account " << account_id
+                    << ": upsert outputs_found failed"
+                    << " in blocks " << h1 << " to " << h2
+                    << ' ' << outputs_found;
+            throw DbWriterException("upsert outputs_found failed");
+        }
+
+        rows_changed |= no_of_affected > no_of_new_outs;
+
+        if (!window_write.inputs_of_window_outputs.empty())
+        {
+            // ids of the outputs of our txs. rescanned txs keep their
+            // old ids, so they are selected by ids of the txs, not by
+            // a range of ids, which could cover most of the account
+            vector<XmrOutput> outputs_in_mysql;
+
+            xmr_accounts.select_outputs_for_txs(tx_mysql_ids,
+                                                outputs_in_mysql, conn);
+
+            unordered_map<string, uint64_t> output_ids_by_pub_key;
+
+            for (auto const& out_row: outputs_in_mysql)
+                output_ids_by_pub_key[out_row.out_pub_key] = out_row.id.data;
+
+            for (auto const& in_out: window_write.inputs_of_window_outputs)
+            {
+                auto it = output_ids_by_pub_key.find(in_out.second);
+
+                if (it == output_ids_by_pub_key.end())
+                    throw DbWriterException("Cant find id of output "
+                                            + in_out.second);
+
+                inputs_found.at(in_out.first).output_id = it->second;
+            }
+        }
+
+        if (!xmr_accounts.upsert(inputs_found, no_of_affected, conn))
+        {
+            OMERROR << "Account " << account_id
+                    << ": upsert inputs_found failed"
+                    << " in blocks " << h1 << " to " << h2
+                    << ' ' << inputs_found;
+            throw DbWriterException("upsert inputs_found failed");
+        }
+
+        rows_changed |= no_of_affected > no_of_new_ins;
+
+        if (rows_changed && !xmr_accounts.bump_changes(account_id, conn))
+            throw DbWriterException("Cant count changes of account "
+                                    + std::to_string(account_id));
+    }
+
+    // update scanned_block_height of the account
+    // in the same transaction as its rows
+    window_write.acc_updated = xmr_accounts.update(
+                window_write.acc, window_write.updated_acc, conn);
+}
+
+void
+DbWriter::stop()
+{
+    {
+        std::lock_guard<std::mutex> lck (queue_mtx);
+        done = true;
+    }
+
+    queued_cv.notify_all();
+    not_full_cv.notify_all();
+
+    if (writer_thread.joinable())
+        writer_thread.join();
+}
+
+size_t
+DbWriter::queue_size()
+{
+    std::lock_guard<std::mutex> lck (queue_mtx);
+    return queue.size();
+}
+
+DbWriter::~DbWriter()
+{
+    stop();
+}
+
+}
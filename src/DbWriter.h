@@ -0,0 +1,146 @@
+#pragma once
+
+#define MYSQLPP_SSQLS_NO_STATICS 1
+
+#include "om_log.h"
+#include "db/ssqlses.h"
+#include "db/MySqlAccounts.h"
+
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <future>
+#include <memory>
+#include <vector>
+#include <stdexcept>
+#include <condition_variable>
+
+namespace xmreg
+{
+
+using namespace std;
+
+class DbWriterException: public std::runtime_error
+{
+public:
+    using std::runtime_error::runtime_error;
+};
+
+// rows found by TxSearch in one scan window, and the update of
+// scanned_block_height of its account. until written, tx_id of
+// outputs and inputs is the index of their tx in txs.
+struct WindowWrite
+{
+    uint64_t account_id {0};
+
+    // blocks of the window
+    uint64_t h1 {0};
+    uint64_t h2 {0};
+
+    vector<XmrTransaction> txs;
+    vector<XmrOutput> outputs;
+    vector<XmrInput> inputs;
+
+    // inputs which spend outputs from this window, with
+    // public keys of these outputs. their output_id is
+    // known only after the outputs are written
+    vector<pair<size_t, string>> inputs_of_window_outputs;
+
+    // account row before and after the window
+    XmrAccount acc;
+    XmrAccount updated_acc;
+
+    // set by the writer. false if the account row was
+    // changed by someone else in the meantime
+    bool acc_updated {false};
+};
+
+/*
+ * Single thread writing results of all scanners into mysql.
+ *
+ * Before, each TxSearch wrote its window in its own mysql
+ * transaction, so scanning was bound by commit latency of every
+ * account, and each scanning account held its own connection.
+ *
+ * Now scanners hand their WindowWrite to the writer. Everything
+ * queued while the previous commit was in progress is written in
+ * one mysql transaction (group commit). If such a group fails, its
+ * windows are written again one by one, so that one bad window
+ * does not fail windows of other accounts.
+ *
+ * The queue is bounded. When its full, scanners wait, so they can't
+ * get far ahead of mysql. write returns only after the window is
+ * committed, so TxSearch reports new scanned_block_height
+ * to clients only when its rows are already in mysql.
+ */
+class DbWriter
+{
+public:
+
+    DbWriter(size_t _max_queued = 64);
+
+    // queues the window and waits until its committed.
+    // rethrows exception if it could not be written
+    virtual void
+    write(shared_ptr<WindowWrite> window_write);
+
+    // writes the window using the given connection. mysql
+    // transaction, if any, is managed by the caller
+    static void
+    write_window(MySqlAccounts& xmr_accounts,
+                 WindowWrite& window_write,
+                 shared_ptr<mysqlpp::Connection> conn);
+
+    // writes all queued windows and joins the writer thread
+    virtual ~DbWriter();
+
+protected:
+
+    // writes the windows in one mysql transaction,
+    // or throws if any of them cant be written
+    virtual void
+    commit_windows(vector<WindowWrite*> const& windows);
+
+    // to be called by destructors of derived classes, so that
+    // the queue is written before their commit_windows is gone
+    void
+    stop();
+
+    // number of windows waiting for the next group
+    size_t
+    queue_size();
+
+private:
+
+    struct QueuedWrite
+    {
+        shared_ptr<WindowWrite> window_write;
+        std::promise<void> committed;
+    };
+
+    void
+    writer_loop();
+
+    void
+    commit_group(deque<QueuedWrite>& group);
+
+    size_t max_queued;
+
+    deque<QueuedWrite> queue;
+
+    bool done {false};
+
+    mutex queue_mtx;
+
+    // signaled when something is queued
+    condition_variable queued_cv;
+
+    // signaled when the writer takes windows from the queue
+    condition_variable not_full_cv;
+
+    shared_ptr<MySqlAccounts> xmr_accounts;
+
+    std::thread writer_thread;
+};
+
+}
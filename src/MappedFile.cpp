@@ -0,0 +1,72 @@
+#include "MappedFile.h"
+
+#include "om_log.h"
+
+#include <boost/filesystem.hpp>
+
+#include <fstream>
+
+namespace xmreg
+{
+
+namespace bi = boost::interprocess;
+namespace bf = boost::filesystem;
+
+bool
+MappedFile::map(uint64_t new_size)
+{
+    try
+    {
+        unmap();
+
+        if (!bf::exists(path))
+        {
+            // just create empty file
+            std::ofstream f(path, std::ios::binary);
+        }
+
+        if (bf::file_size(path) < new_size)
+            bf::resize_file(path, new_size);
+
+        mapping = std::make_unique<bi::file_mapping>(
+                    path.c_str(), bi::read_write);
+
+        region = std::make_unique<bi::mapped_region>(
+                    *mapping, bi::read_write);
+    }
+    catch (std::exception const& e)
+    {
+        OMERROR << "Cant map " << path << ": " << e.what();
+        return false;
+    }
+
+    return true;
+}
+
+void
+MappedFile::unmap()
+{
+    region.reset();
+    mapping.reset();
+}
+
+uint64_t
+MappedFile::size() const
+{
+    return region ? region->get_size() : 0;
+}
+
+char*
+MappedFile::data() const
+{
+    return static_cast<char*>(region->get_address());
+}
+
+void
+MappedFile::flush()
+{
+    if (region)
+        region->flush();
+}
+
+}
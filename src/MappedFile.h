@@ -0,0 +1,60 @@
+#pragma once
+
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+#include <string>
+#include <memory>
+
+namespace xmreg
+{
+
+using namespace std;
+
+/*
+ * File mapped into memory read-write, which can grow.
+ *
+ * Used by on-disk indices (RingMemberIndex, ScanDigest).
+ * Pointers into data() are invalidated by map() and unmap().
+ */
+class MappedFile
+{
+public:
+
+    void
+    set_path(string _path)
+    {
+        path = _path;
+    }
+
+    string const&
+    get_path() const
+    {
+        return path;
+    }
+
+    // creates the file if it does not exist and makes it
+    // at least new_size bytes long before mapping it
+    bool
+    map(uint64_t new_size);
+
+    void
+    unmap();
+
+    uint64_t
+    size() const;
+
+    char*
+    data() const;
+
+    void
+    flush();
+
+private:
+    string path;
+
+    unique_ptr<boost::interprocess::file_mapping> mapping;
+    unique_ptr<boost::interprocess::mapped_region> region;
+};
+
+}
@@ -33,7 +33,8 @@ handel_::operator()(const shared_ptr< Session > session)
 OpenMoneroRequests::OpenMoneroRequests(
         shared_ptr<MySqlAccounts> _acc, 
         shared_ptr<CurrentBlockchainStatus> _current_bc_status):
-    xmr_accounts {_acc}, current_bc_status {_current_bc_status}
+    xmr_accounts {_acc}, current_bc_status {_current_bc_status},
+    etag_key {crypto::rand<crypto::hash>()}
 {
 
 }
@@ -236,10 +237,26 @@ OpenMoneroRequests::get_address_txs(
     string xmr_address;
     string view_key;
 
+    // optional cursor returned in previous response. with it,
+    // only txs which are new or still can change are returned
+    bool incremental {false};
+    uint64_t since_tx_id {0};
+    uint64_t since_mempool_version {0};
+    json j_since;
+
     try
     {
         xmr_address = j_request["address"];
         view_key    = j_request["view_key"];
+
+        if (j_request.count("since"))
+        {
+            j_since = j_request["since"];
+
+            since_tx_id           = j_since["tx_id"];
+            since_mempool_version = j_since["mempool_version"];
+            incremental = true;
+        }
     }
     catch (json::exception const& e)
     {
@@ -248,6 +265,11 @@ OpenMoneroRequests::get_address_txs(
         return;
     }
 
+    string etag = make_etag(xmr_address, body);
+
+    if (close_if_not_modified(session, xmr_address, view_key, etag))
+        return;
+
     // make hash of the submited viewkey. we only store
     // hash of viewkey in database, not acctual viewkey.
     string viewkey_hash = make_hash(view_key);
@@ -279,6 +301,10 @@ OpenMoneroRequests::get_address_txs(
         return;
     }
 
+    // search thread could have been just started
+    if (etag.empty())
+        etag = make_etag(xmr_address, body);
+
     // before fetching txs, check if provided view key
     // is correct. this is simply to ensure that
     // we cant fetch an account's txs using only address.
@@ -294,12 +320,88 @@ OpenMoneroRequests::get_address_txs(
                 acc.scanned_block_timestamp);
     j_response["blockchain_height"]  = get_current_blockchain_height();
 
+    // read before mempool txs are searched, so that
+    // any later change gives different version
+    uint64_t mempool_version = current_bc_status->get_mempool_version();
+
+    uint64_t service_epoch = current_bc_status->get_service_epoch();
+
+    // read before txs, so that updates and deletes made while
+    // they are read give full response to the next request
+    uint64_t account_changes {0};
+
+    // txs updated or removed since the cursor, or restart of the
+    // service, cant be told by ids, so all txs are returned
+    if (!xmr_accounts->get_changes(acc.id.data, account_changes)
+            || !since_cursor_valid(j_since, account_changes, service_epoch))
+        incremental = false;
+
+    if (!incremental)
+        since_tx_id = 0;
+
     vector<XmrTransaction> txs;
 
-    xmr_accounts->select(acc.id.data, txs);
+    // spent outputs and their total for txs which have inputs
+    unordered_map<uint64_t, pair<json, uint64_t>> txs_spent_outputs;
+
+    uint64_t last_tx_id {since_tx_id};
 
-    if (xmr_accounts->select_txs_for_account_spendability_check(
-                acc.id.data, txs))
+    bool txs_checked {false};
+
+    while (true)
+    {
+        // txs together with their inputs and spent outputs are fetched
+        // in one query, rather than two queries for each tx and input.
+        vector<XmrTransactionWithOutsAndIns> txs_rows;
+
+        xmr_accounts->select_since(acc.id.data, since_tx_id, txs_rows);
+
+        txs.clear();
+        txs_spent_outputs.clear();
+
+        last_tx_id = since_tx_id;
+
+        for (XmrTransactionWithOutsAndIns const& row: txs_rows)
+        {
+            // rows are ordered by tx id
+            if (txs.empty() || txs.back().id.data != row.id.data)
+                txs.push_back(row.get_transaction());
+
+            last_tx_id = std::max<uint64_t>(last_tx_id, row.id.data);
+
+            if (!row.has_input())
+                continue;
+
+            auto& spent_outputs = txs_spent_outputs[row.id.data];
+
+            if (spent_outputs.first.is_null())
+                spent_outputs.first = json::array();
+
+            if (row.has_spent_output())
+            {
+                spent_outputs.first.push_back(row.spent_output());
+                spent_outputs.second += row.spent_amount.data;
+            }
+        }
+
+        size_t no_of_txs = txs.size();
+
+        txs_checked = xmr_accounts->select_txs_for_account_spendability_check(
+                    acc.id.data, txs);
+
+        // some txs got orphaned and were removed. client would
+        // not know it from returned txs, so we return all of them
+        if (!incremental || txs.size() == no_of_txs)
+            break;
+
+        incremental = false;
+        since_tx_id = 0;
+    }
+
+    // used to set ids of mempool txs
+    uint64_t last_blockchain_tx_id {0};
+
+    if (txs_checked)
     {
         json j_txs = json::array();
 
@@ -320,37 +422,14 @@ OpenMoneroRequests::get_address_txs(
                     {"mempool"        , false} // tx in database are never from mempool
             };
 
-            vector<XmrInput> inputs;
+            auto spent_it = txs_spent_outputs.find(tx.id.data);
 
-            if (xmr_accounts->select_for_tx(tx.id.data, inputs))
+            if (spent_it != txs_spent_outputs.end())
             {
-                json j_spent_outputs = json::array();
-
-                uint64_t total_spent {0};
-
-                for (XmrInput input: inputs)
-                {
-                    XmrOutput out;
-
-                    if (xmr_accounts->select_by_primary_id(
-                                input.output_id, out))
-                    {
-                        total_spent += input.amount;
-
-                        j_spent_outputs.push_back({
-                          {"amount"     , std::to_string(input.amount)},
-                          {"key_image"  , input.key_image},
-                          {"tx_pub_key" , out.tx_pub_key},
-                          {"out_index"  , out.out_index},
-                          {"mixin"      , out.mixin}});
-                    }
-                }
-
-                j_tx["total_sent"] = std::to_string(total_spent);
+                j_tx["total_sent"] = std::to_string(spent_it->second.second);
 
-                j_tx["spent_outputs"] = j_spent_outputs;
-
-            } // if (xmr_accounts->select_inputs_for_tx(tx.id, inputs))
+                j_tx["spent_outputs"] = std::move(spent_it->second.first);
+            }
 
             total_received += tx.total_received;
 
@@ -359,16 +438,43 @@ OpenMoneroRequests::get_address_txs(
                 total_received_unlocked += tx.total_received;
             }
 
+            last_blockchain_tx_id = std::max<uint64_t>(
+                        last_blockchain_tx_id, tx.blockchain_tx_id);
+
             j_txs.push_back(j_tx);
 
         } // for (XmrTransaction tx: txs)
 
+        // we dont have all txs, so totals are summed by mysql
+        if (incremental)
+        {
+            xmr_accounts->get_txs_totals(acc.id.data,
+                                         total_received,
+                                         total_received_unlocked,
+                                         last_blockchain_tx_id);
+        }
+
         j_response["total_received"]          = std::to_string(total_received);
         j_response["total_received_unlocked"] = std::to_string(total_received_unlocked);
 
         j_response["transactions"] = j_txs;
 
-    } // if (xmr_accounts->select_txs_for_ac
+    } // if (txs_checked)
+
+    // with incremental response, transactions are only new or
+    // updated ones. client passes cursor as since in next request
+    j_response["incremental"] = incremental;
+    j_response["cursor"] = json {{"tx_id"          , last_tx_id},
+                                 {"mempool_version", mempool_version},
+                                 {"changes"        , account_changes},
+                                 {"epoch"          , service_epoch}};
+
+    // mempool txs are returned only when mempool changed, and
+    // then they replace those returned before
+    bool mempool_changed = !incremental
+            || since_mempool_version != mempool_version;
+
+    j_response["mempool_changed"] = mempool_changed;
 
     // append txs found in mempool to the json returned
 
@@ -386,12 +492,7 @@ OpenMoneroRequests::get_address_txs(
             // set some ids for the mempool txs. These ids are
             // used for sorting in the frontend. Since we want mempool
             // tx to be first, they need to be higher than last_tx_id_db
-            uint64_t last_tx_id_db {0};
-
-            if (!j_response["transactions"].empty())
-            {
-                last_tx_id_db = j_response["transactions"].back()["id"];
-            }
+            uint64_t last_tx_id_db {last_blockchain_tx_id};
 
 
             for (json& j_tx: j_mempool_tx)
@@ -406,7 +507,8 @@ OpenMoneroRequests::get_address_txs(
                 total_sent_mempool     += boost::lexical_cast<uint64_t>(
                             j_tx["total_sent"].get<string>());
 
-                j_response["transactions"].push_back(j_tx);
+                if (mempool_changed)
+                    j_response["transactions"].push_back(j_tx);
             }
 
             // we account for mempool txs when providing final
@@ -433,6 +535,9 @@ OpenMoneroRequests::get_address_txs(
     auto response_headers = make_headers(
             {{ "Content-Length", to_string(response_body.size()) }});
 
+    if (!etag.empty())
+        response_headers.insert({"ETag", etag});
+
     session->close(OK, response_body, response_headers);
 }
 
@@ -454,10 +559,24 @@ OpenMoneroRequests::get_address_info(
     string xmr_address;
     string view_key;
 
+    // optional cursor returned in previous response. with it,
+    // only spent outputs found since then are returned
+    bool incremental {false};
+    uint64_t since_input_id {0};
+    json j_since;
+
     try
     {
         xmr_address = j_request["address"];
         view_key    = j_request["view_key"];
+
+        if (j_request.count("since"))
+        {
+            j_since = j_request["since"];
+
+            since_input_id = j_since["input_id"];
+            incremental = true;
+        }
     }
     catch (json::exception const& e)
     {
@@ -466,6 +585,11 @@ OpenMoneroRequests::get_address_info(
         return;
     }
 
+    string etag = make_etag(xmr_address, body);
+
+    if (close_if_not_modified(session, xmr_address, view_key, etag))
+        return;
+
     // make hash of the submited viewkey. we only store
     // hash of viewkey in database, not acctual viewkey.
     string viewkey_hash = make_hash(view_key);
@@ -493,6 +617,10 @@ OpenMoneroRequests::get_address_info(
     // created and still exisits.
     if (login_and_start_search_thread(xmr_address, view_key, acc, j_response))
     {
+        // search thread could have been just started
+        if (etag.empty())
+            etag = make_etag(xmr_address, body);
+
         uint64_t total_received {0};
 
         // ping the search thread that we still need it.
@@ -525,55 +653,70 @@ OpenMoneroRequests::get_address_info(
 
         uint64_t total_sent {0};
 
+        uint64_t service_epoch = current_bc_status->get_service_epoch();
+
+        // read before inputs, so that their removal or update while
+        // they are read gives full response to the next request
+        uint64_t account_changes {0};
+
+        if (!xmr_accounts->get_changes(acc.id.data, account_changes)
+                || !since_cursor_valid(j_since, account_changes,
+                                       service_epoch))
+            incremental = false;
+
+        if (!incremental)
+            since_input_id = 0;
+
         vector<XmrTransaction> txs;
 
         // get all txs of for the account
         xmr_accounts->select(acc.id.data, txs);
 
+        size_t no_of_txs = txs.size();
+
         // now, filter out or updated transactions from txs vector that no
         // longer exisit in the recent blocks. Update is done to check for their
         // spendability status.
         if (xmr_accounts->select_txs_for_account_spendability_check(
                     acc.id.data, txs))
         {
-            json j_spent_outputs = json::array();
-
-            for (XmrTransaction tx: txs)
+            // orphaned txs were removed, together with their
+            // inputs, so client must get all spent outputs again
+            if (txs.size() != no_of_txs)
             {
-                vector<XmrOutput> outs;
+                incremental = false;
+                since_input_id = 0;
+            }
 
-                if (xmr_accounts->select_for_tx(tx.id.data, outs))
-                {
-                    for (XmrOutput &out: outs)
-                    {
-                        // check if the output, has been spend
-                        vector<XmrInput> ins;
+            // totals and spent outputs are calculated by mysql for
+            // the whole account, rather than by going through each output
+            // of each tx, and querying for its inputs.
+            xmr_accounts->get_total_received_and_sent(
+                        acc.id.data, total_received, total_sent);
 
-                        if (xmr_accounts->select_inputs_for_out(
-                                    out.id.data, ins))
-                        {
-                            for (XmrInput& in: ins)
-                            {
-                                j_spent_outputs.push_back({
-                                    {"amount"     , std::to_string(in.amount)},
-                                    {"key_image"  , in.key_image},
-                                    {"tx_pub_key" , out.tx_pub_key},
-                                    {"out_index"  , out.out_index},
-                                    {"mixin"      , out.mixin},
-                                });
-
-                                total_sent += in.amount;
-                            }
-                        }
+            vector<XmrSpentOutput> spent_outputs;
 
-                        total_received += out.amount;
+            xmr_accounts->select_since(acc.id.data, since_input_id,
+                                       spent_outputs);
+
+            json j_spent_outputs = json::array();
 
-                    } //  for (XmrOutput &out: outs)
+            uint64_t last_input_id {since_input_id};
 
-                } //  if (xmr_accounts->select_outputs_for_tx(tx.id, outs))
+            for (XmrSpentOutput const& spent_output: spent_outputs)
+            {
+                j_spent_outputs.push_back(spent_output.to_json());
 
-            } // for (XmrTransaction tx: txs)
+                last_input_id = std::max<uint64_t>(last_input_id,
+                                                   spent_output.id);
+            }
 
+            // with incremental response, spent_outputs has only new
+            // ones. client passes cursor as since in next request
+            j_response["incremental"] = incremental;
+            j_response["cursor"] = json {{"input_id", last_input_id},
+                                         {"changes" , account_changes},
+                                         {"epoch"   , service_epoch}};
 
             j_response["total_received"] = std::to_string(total_received);
             j_response["total_sent"]     = std::to_string(total_sent);
@@ -598,6 +741,9 @@ OpenMoneroRequests::get_address_info(
     auto response_headers = make_headers({{ "Content-Length",
                                             to_string(response_body.size())}});
 
+    if (!etag.empty())
+        response_headers.insert({"ETag", etag});
+
     session->close( OK, response_body, response_headers);
 }
 
@@ -687,141 +833,115 @@ OpenMoneroRequests::get_unspent_outs(
 //        uint64_t current_blockchain_height
 //                = current_bc_status->get_current_blockchain_height();
 
-        vector<XmrTransaction> txs;
+        // locked outputs and outputs considered as dust are
+        // skipped by mysql, as they cant be spent anyway.
+        // thus no reason to return them to the frontend
+        // for constructing a tx.
+        vector<XmrUnlockedOutput> outs;
 
-        // retrieve txs from mysql associated with the given address
-        if (xmr_accounts->select(acc.id.data, txs))
+        if (xmr_accounts->select_unlocked_outputs(
+                    acc.id.data, dust_threshold,
+                    current_bc_status->get_unlock_limits(), outs))
         {
-            // we found some txs.
+            // we found some outputs.
 
             json& j_outputs = j_response["outputs"];
 
-            for (XmrTransaction& tx: txs)
-            {
-                // we skip over locked outputs
-                // as they cant be spent anyway.
-                // thus no reason to return them to the frontend
-                // for constructing a tx.
+            uint64_t last_output_id {0};
 
-                if (!current_bc_status->is_tx_unlocked(
-                            tx.unlock_time, tx.height))
+            for (XmrUnlockedOutput const& out: outs)
+            {
+                // rows with inputs of the same output are next
+                // to each other, so we only add their key images
+                if (!j_outputs.empty() && out.id == last_output_id)
                 {
+                    j_outputs.back()["spend_key_images"]
+                            .push_back(out.key_image.data);
                     continue;
                 }
 
+                // need to check for rct commintment
+                // coinbase ringct txs dont have
+                // rct filed in them. Thus
+                // we need to make them.
+
+                // default case. it will cover 
+                // rct types 1 (Full) and 2 (Simple)
+                // rct types explained here: 
+                // https://monero.stackexchange.com/questions/3348/what-are-3-types-of-ring-ct-transactions
+                string rct = out.rct_outpk + out.rct_mask + out.rct_amount;
 
-                vector<XmrOutput> outs;
+                // based on 
+                // https://github.com/mymonero/mymonero-app-js/issues/277#issuecomment-469395825
 
-                if (!xmr_accounts->select_for_tx(tx.id.data, outs))
+                if (!out.is_rct)
                 {
-                    continue;
+                    // point 1: null/undefined/empty: 
+                    // non-RingCT output (i.e, from version 1 tx)
+                    // covers all pre-ringct outputs
+                    rct = "";
                 }
-
-                for (XmrOutput &out: outs)
+                else    
                 {
-                    // skip outputs considered as dust
-                    if (out.amount < dust_threshold)
-                    {
-                        continue;
-                    }
-
-                    // need to check for rct commintment
-                    // coinbase ringct txs dont have
-                    // rct filed in them. Thus
-                    // we need to make them.
-
-                    uint64_t global_amount_index = out.global_index;
-
-                    // default case. it will cover 
-                    // rct types 1 (Full) and 2 (Simple)
-                    // rct types explained here: 
-                    // https://monero.stackexchange.com/questions/3348/what-are-3-types-of-ring-ct-transactions
-                    string rct = out.get_rct();
-
-                    // based on 
-                    // https://github.com/mymonero/mymonero-app-js/issues/277#issuecomment-469395825
-
-                    if (!tx.is_rct)
-                    {
-                        // point 1: null/undefined/empty: 
-                        // non-RingCT output (i.e, from version 1 tx)
-                        // covers all pre-ringct outputs
-                        rct = "";
-                    }
-                    else    
-                    {
-                        // for RingCT:
-                                                     
-                       if (tx.rct_type == 0)
-                       {
-                       // coinbase rct txs require speciall treatment
-                       // point 2: string "coinbase" (length 8): 
-                       // RingCT coinbase output
+                    // for RingCT:
+                                                 
+                   if (out.rct_type == 0)
+                   {
+                   // coinbase rct txs require speciall treatment
+                   // point 2: string "coinbase" (length 8): 
+                   // RingCT coinbase output
+                   
+                    rct = "coinbase";
+                   }
+                   else if (out.rct_type == 5)
+                   {                               
+                       // point 5: string length 192: non-coinbase RingCT 
+                       // version 1 output with 256-bit amount and mask
+                       // rct type 5 is Booletproof
                        
-                        rct = "coinbase";
-                       }
-                       else if (tx.rct_type == 5)
-                       {                               
-                           // point 5: string length 192: non-coinbase RingCT 
-                           // version 1 output with 256-bit amount and mask
-                           // rct type 5 is Booletproof
-                           
-                           rct = out.rct_outpk + out.rct_mask + out.rct_amount;
-                       }
-                       else if (tx.rct_type == 6)
-                       {
-                           // point 6 string length 80: 
-                           // non-coinbase RingCT version 2 
-                           // output 64 bit amount
-                           // rct type 6 is Booletproof2
-                           
-                           rct = out.rct_outpk + out.rct_amount.substr(0,16);
-                       }
-                    }
-
-                    //cout << "tx hash: " << tx.hash  << ", rtc: " << rct 
-                    //     << ", rtc size: " << rct.size()  
-                    //     << ", decrypted mask: " << out.rct_mask
-                    //     << endl;
-
-                    json j_out{
-                            {"amount"          , std::to_string(out.amount)},
-                            {"public_key"      , out.out_pub_key},
-                            {"index"           , out.out_index},
-                            {"global_index"    , out.global_index},
-                            {"rct"             , rct},
-                            {"tx_id"           , out.tx_id},
-                            {"tx_hash"         , tx.hash},
-                            {"tx_prefix_hash"  , tx.prefix_hash},
-                            {"tx_pub_key"      , tx.tx_pub_key},
-                            {"timestamp"       , static_cast<uint64_t>(
-                                        out.timestamp*1e3)},
-                            {"height"          , tx.height},
-                            {"spend_key_images", json::array()}
-                    };
-
-                    vector<XmrInput> ins;
-
-                    if (xmr_accounts->select_inputs_for_out(
-                                out.id.data, ins))
-                    {
-                        json& j_ins = j_out["spend_key_images"];
+                       rct = out.rct_outpk + out.rct_mask + out.rct_amount;
+                   }
+                   else if (out.rct_type == 6)
+                   {
+                       // point 6 string length 80: 
+                       // non-coinbase RingCT version 2 
+                       // output 64 bit amount
+                       // rct type 6 is Booletproof2
+                       
+                       rct = out.rct_outpk + out.rct_amount.substr(0,16);
+                   }
+                }
 
-                        for (XmrInput& in: ins)
-                        {
-                            j_ins.push_back(in.key_image);
-                        }
-                    }
+                json j_out{
+                        {"amount"          , std::to_string(out.amount)},
+                        {"public_key"      , out.out_pub_key},
+                        {"index"           , out.out_index},
+                        {"global_index"    , out.global_index},
+                        {"rct"             , rct},
+                        {"tx_id"           , out.tx_id},
+                        {"tx_hash"         , out.tx_hash},
+                        {"tx_prefix_hash"  , out.tx_prefix_hash},
+                        {"tx_pub_key"      , out.tx_pub_key},
+                        {"timestamp"       , static_cast<uint64_t>(
+                                    out.timestamp*1e3)},
+                        {"height"          , out.height},
+                        {"spend_key_images", json::array()}
+                };
 
-                    j_outputs.push_back(j_out);
+                if (!out.key_image.is_null)
+                {
+                    j_out["spend_key_images"].push_back(out.key_image.data);
+                }
 
-                    total_outputs_amount += out.amount;
+                j_outputs.push_back(j_out);
 
-                }  //for (XmrOutput &out: outs)
+                last_output_id = out.id;
 
-            } // for (XmrTransaction& tx: txs)
+                total_outputs_amount += out.amount;
 
-        } //  if (xmr_accounts->select_txs(acc.id, txs))
+            }  //for (XmrUnlockedOutput const& out: outs)
+
+        } //  if (xmr_accounts->select_unlocked_outputs(acc.id, ...))
 
         j_response["amount"] = std::to_string(total_outputs_amount);
 
@@ -1585,25 +1705,14 @@ OpenMoneroRequests::get_tx(
     if (!current_bc_status->get_tx(tx_hash, tx))
     {
         // if tx not found in the blockchain, check if its in mempool
+        auto mtx = current_bc_status->find_mempool_tx(tx_hash);
 
-                // recieved_time, tx
-        vector<pair<uint64_t, transaction>> mempool_txs =
-                current_bc_status->get_mempool_txs();
-
-        //cout << "serach mempool" << endl;
-
-        for (auto const& mtx: mempool_txs)
+        if (mtx)
         {
-            //cout << (get_transaction_hash(mtx.second)) << '\n';
-
-            if (get_transaction_hash(mtx.second) == tx_hash)
-            {
-                tx = mtx.second;
-                tx_found = true;
-                tx_in_mempool = true;
-                default_timestamp = mtx.first;
-                break;
-            }
+            tx = mtx->tx;
+            tx_found = true;
+            tx_in_mempool = true;
+            default_timestamp = mtx->receive_time;
         }
     }
     else
@@ -1979,15 +2088,11 @@ OpenMoneroRequests::confirm_tx_sent(const shared_ptr<Session> session, const Byt
 
     // Not found in blockchain, find in mempool
     if (!tx_found) {
-        vector<pair<uint64_t, transaction>> mempool_txs = current_bc_status->get_mempool_txs();
-        for (auto const& mtx: mempool_txs)
+        auto mtx = current_bc_status->find_mempool_tx(tx_hash);
+        if (mtx)
         {
-            if (get_transaction_hash(mtx.second) == tx_hash)
-            {
-                tx = mtx.second;
-                tx_found = true;
-                break;
-            }
+            tx = mtx->tx;
+            tx_found = true;
         }
     }
 
@@ -2133,7 +2238,8 @@ OpenMoneroRequests::make_headers(
 {
     multimap<string, string> headers {
             {"Access-Control-Allow-Origin"     , "*"},
-            {"Access-Control-Allow-Headers"    , "Content-Type"},
+            {"Access-Control-Allow-Headers"    , "Content-Type, If-None-Match"},
+            {"Access-Control-Expose-Headers"   , "ETag"},
             {"Content-Type"                    , "application/json"}
     };
 
@@ -2538,6 +2644,84 @@ OpenMoneroRequests::select_payment(
      return xmr_payments.at(0);
 }
 
+bool
+OpenMoneroRequests::since_cursor_valid(json const& j_since,
+                                       uint64_t account_changes,
+                                       uint64_t service_epoch)
+{
+    // cursors from before changes and epoch were added
+    // to them are never valid
+    if (!j_since.is_object()
+            || !j_since.count("changes") || !j_since.count("epoch"))
+        return false;
+
+    try
+    {
+        return j_since["changes"].get<uint64_t>() == account_changes
+                && j_since["epoch"].get<uint64_t>() == service_epoch;
+    }
+    catch (json::exception const&)
+    {
+        return false;
+    }
+}
+
+string
+OpenMoneroRequests::make_etag(string const& xmr_address,
+                              const Bytes & body) const
+{
+    uint64_t state_version {0};
+
+    if (!current_bc_status->get_account_state_version(
+                xmr_address, state_version))
+        return {};
+
+    // keccak has no length extension, so hash of
+    // the key followed by the data is enough as mac
+    string data {reinterpret_cast<char const*>(&etag_key),
+                 sizeof(etag_key)};
+
+    data += xmr_address + '-' + std::to_string(state_version)
+            + '-' + std::to_string(get_current_blockchain_height())
+            + '-' + body_to_string(body);
+
+    crypto::hash etag_hash;
+    crypto::cn_fast_hash(data.data(), data.size(), etag_hash);
+
+    return "\"" + pod_to_hex(etag_hash) + "\"";
+}
+
+bool
+OpenMoneroRequests::close_if_not_modified(
+        const shared_ptr< Session > session,
+        string const& xmr_address,
+        string const& view_key,
+        string const& etag) const
+{
+    if (etag.empty())
+        return false;
+
+    string if_none_match = session->get_request()
+                                  ->get_header("If-None-Match", string {});
+
+    if (if_none_match != etag)
+        return false;
+
+    // 304 tells when the account changed, so its only for those
+    // who know its view key. others get usual response, which
+    // checks the view key before giving anything
+    if (!current_bc_status->search_thread_exist(xmr_address, view_key))
+        return false;
+
+    // this poll also means that the search is still needed
+    current_bc_status->ping_search_thread(xmr_address);
+
+    session->close(NOT_MODIFIED, string {},
+                   make_headers({{"ETag", etag}}));
+
+    return true;
+}
+
 void
 OpenMoneroRequests::session_close(
         const shared_ptr< Session > session,
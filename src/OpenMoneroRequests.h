@@ -65,6 +65,11 @@ class OpenMoneroRequests
    shared_ptr<MySqlAccounts> xmr_accounts;
    shared_ptr<CurrentBlockchainStatus> current_bc_status;
 
+   // random key of ETags, new after every restart, as state
+   // versions of accounts start from 0 then. ETags are its keccak
+   // hash with the request, so they cant be guessed by others
+   crypto::hash etag_key;
+
 public:
 
     OpenMoneroRequests(shared_ptr<MySqlAccounts> _acc,
@@ -138,6 +143,14 @@ public:
     static void
     print_json_log(const string& text, const json& j);
 
+    // since cursor of get_address_txs or get_address_info is valid
+    // if no rows of the account were updated or deleted, and the
+    // service was not restarted, since it was returned. otherwise
+    // rows after it are not all that changed
+    static bool
+    since_cursor_valid(json const& j_since, uint64_t account_changes,
+                       uint64_t service_epoch);
+
     static inline string
     body_to_string(const Bytes & body);
 
@@ -179,6 +192,23 @@ private:
     boost::optional<XmrPayment>
     select_payment(XmrAccount const& xmr_account) const;
 
+    // ETag for responses of get_address_txs and get_address_info.
+    // its keyed hash of account's state version, blockchain height
+    // and the request body, so different view_key or since give
+    // different ETag. empty if the account is not being searched.
+    string
+    make_etag(string const& xmr_address, const Bytes & body) const;
+
+    // responds with 304 if If-None-Match of the request is the
+    // etag and view_key is of the account. done without mysql
+    // or making json response.
+    bool
+    close_if_not_modified(
+            const shared_ptr< Session > session,
+            string const& xmr_address,
+            string const& view_key,
+            string const& etag) const;
+
      void
     session_close(
             const shared_ptr< Session > session,
@@ -0,0 +1,494 @@
+#include "RingMemberIndex.h"
+
+#include "om_log.h"
+
+#include <boost/filesystem.hpp>
+
+namespace xmreg
+{
+
+namespace bf = boost::filesystem;
+
+constexpr uint64_t RingMemberIndex::magic;
+constexpr uint64_t RingMemberIndex::no_record;
+
+namespace
+{
+
+uint64_t
+hash_index(uint64_t amount, uint64_t global_index)
+{
+    // splitmix64 finalizer
+    uint64_t x = amount * 0x9e3779b97f4a7c15ULL ^ global_index;
+
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+
+    return x ^ (x >> 31);
+}
+
+uint64_t
+next_pow2(uint64_t n)
+{
+    uint64_t p {1};
+
+    while (p < n)
+        p <<= 1;
+
+    return p;
+}
+
+}
+
+RingMemberIndex::RingMemberIndex(string _dir)
+    : dir {_dir}
+{
+    records_file.set_path((bf::path(dir) / "records.bin").string());
+    heads_file.set_path((bf::path(dir) / "heads.bin").string());
+    blocks_file.set_path((bf::path(dir) / "blocks.bin").string());
+}
+
+bool
+RingMemberIndex::open()
+{
+    std::lock_guard<std::mutex> lck (index_mtx);
+
+    try
+    {
+        bf::create_directories(dir);
+    }
+    catch (std::exception const& e)
+    {
+        OMERROR << "Cant create " << dir << ": " << e.what();
+        return false;
+    }
+
+    bool new_index = !bf::exists(records_file.get_path());
+
+    if (!records_file.map(sizeof(RecordsHeader)
+                          + (1 << 16) * sizeof(Record)))
+        return false;
+
+    if (new_index)
+    {
+        *records_header() = {magic, 0, 0};
+    }
+    else if (records_header()->magic != magic)
+    {
+        OMERROR << records_file.get_path() << " is not a ring member index";
+        return false;
+    }
+
+    {
+        // drop records of a block which was not fully
+        // added, e.g., due to a crash
+        RecordsHeader* header = records_header();
+
+        uint64_t n = header->no_of_records;
+
+        while (n > 0 && records()[n - 1].height >= header->indexed_height)
+            --n;
+
+        header->no_of_records = n;
+    }
+
+    if (!blocks_file.map((records_header()->indexed_height + 1024)
+                         * sizeof(crypto::hash)))
+        return false;
+
+    if (!bf::exists(heads_file.get_path()))
+    {
+        if (!rebuild_heads(1 << 16))
+            return false;
+    }
+    else
+    {
+        if (!heads_file.map(sizeof(HeadsHeader)))
+            return false;
+
+        // heads were not saved after last records were added,
+        // e.g., due to a crash
+        if (heads_header()->magic != magic
+                || heads_header()->synced_records
+                    != records_header()->no_of_records)
+        {
+            OMWARN << "Rebuilding " << heads_file.get_path();
+
+            uint64_t capacity = heads_header()->magic == magic
+                                ? heads_header()->capacity : 0;
+
+            if (!rebuild_heads(capacity))
+                return false;
+        }
+    }
+
+    is_open = true;
+
+    OMINFO << "Ring member index opened. Indexed blocks: "
+           << records_header()->indexed_height
+           << ", records: " << records_header()->no_of_records;
+
+    return true;
+}
+
+uint64_t
+RingMemberIndex::get_indexed_height()
+{
+    std::lock_guard<std::mutex> lck (index_mtx);
+    return is_open ? records_header()->indexed_height : 0;
+}
+
+bool
+RingMemberIndex::get_block_hash(uint64_t height, crypto::hash& blk_hash)
+{
+    std::lock_guard<std::mutex> lck (index_mtx);
+
+    if (!is_open || height >= records_header()->indexed_height)
+        return false;
+
+    blk_hash = block_hashes()[height];
+
+    return true;
+}
+
+bool
+RingMemberIndex::add_block(uint64_t height,
+                           crypto::hash const& blk_hash,
+                           vector<transaction> const& txs)
+{
+    std::lock_guard<std::mutex> lck (index_mtx);
+
+    if (!is_open || height != records_header()->indexed_height)
+        return false;
+
+    uint64_t no_of_new_records {0};
+
+    for (auto const& tx: txs)
+        for (auto const& in: tx.vin)
+            if (in.type() == typeid(txin_to_key))
+                no_of_new_records += boost::get<txin_to_key>(in)
+                                        .key_offsets.size();
+
+    uint64_t n = records_header()->no_of_records;
+
+    // to go back to if the block cant be fully added
+    uint64_t const no_of_old_records {n};
+
+    if (!reserve_records(n + no_of_new_records)
+            || !reserve_blocks(height + 1))
+    {
+        drop_records_from(no_of_old_records);
+        return false;
+    }
+
+    for (auto const& tx: txs)
+    {
+        for (auto const& in: tx.vin)
+        {
+            if (in.type() != typeid(txin_to_key))
+                continue;
+
+            auto const& in_key = boost::get<txin_to_key>(in);
+
+            vector<uint64_t> absolute_offsets
+                    = relative_output_offsets_to_absolute(
+                            in_key.key_offsets);
+
+            for (uint64_t global_index: absolute_offsets)
+            {
+                Bucket* bucket = find_bucket(in_key.amount, global_index);
+
+                uint64_t prev = (bucket->head == 0
+                                 || bucket->head == no_record)
+                                ? no_record : bucket->head - 1;
+
+                records()[n] = {in_key.amount, global_index, height, prev};
+
+                records_header()->no_of_records = ++n;
+
+                if (!set_head(in_key.amount, global_index, n))
+                {
+                    drop_records_from(no_of_old_records);
+                    return false;
+                }
+            }
+        }
+    }
+
+    block_hashes()[height] = blk_hash;
+
+    records_header()->indexed_height = height + 1;
+    heads_header()->synced_records = n;
+
+    return true;
+}
+
+void
+RingMemberIndex::pop_blocks(uint64_t height)
+{
+    std::lock_guard<std::mutex> lck (index_mtx);
+
+    if (!is_open || height >= records_header()->indexed_height)
+        return;
+
+    uint64_t n = records_header()->no_of_records;
+
+    // records are sorted by height, so we remove them from the end
+    // and make heads point to previous records again
+    while (n > 0 && records()[n - 1].height >= height)
+    {
+        Record r = records()[n - 1];
+
+        set_head(r.amount, r.global_index,
+                 r.prev == no_record ? no_record : r.prev + 1);
+
+        --n;
+    }
+
+    records_header()->no_of_records = n;
+    records_header()->indexed_height = height;
+    heads_header()->synced_records = n;
+
+    ++no_of_pops;
+}
+
+vector<uint64_t>
+RingMemberIndex::find(uint64_t amount,
+                      uint64_t global_index,
+                      uint64_t min_height)
+{
+    std::lock_guard<std::mutex> lck (index_mtx);
+
+    vector<uint64_t> heights;
+
+    if (!is_open)
+        return heights;
+
+    Bucket* bucket = find_bucket(amount, global_index);
+
+    if (bucket->head == 0 || bucket->head == no_record)
+        return heights;
+
+    uint64_t i = bucket->head - 1;
+
+    // records of the same output are linked from the highest
+    while (i != no_record && records()[i].height >= min_height)
+    {
+        heights.push_back(records()[i].height);
+        i = records()[i].prev;
+    }
+
+    return heights;
+}
+
+void
+RingMemberIndex::flush()
+{
+    std::lock_guard<std::mutex> lck (index_mtx);
+
+    for (auto file: {&records_file, &blocks_file, &heads_file})
+        file->flush();
+}
+
+RingMemberIndex::~RingMemberIndex()
+{
+    flush();
+}
+
+RingMemberIndex::RecordsHeader*
+RingMemberIndex::records_header() const
+{
+    return reinterpret_cast<RecordsHeader*>(records_file.data());
+}
+
+RingMemberIndex::Record*
+RingMemberIndex::records() const
+{
+    return reinterpret_cast<Record*>(
+                records_file.data() + sizeof(RecordsHeader));
+}
+
+RingMemberIndex::HeadsHeader*
+RingMemberIndex::heads_header() const
+{
+    return reinterpret_cast<HeadsHeader*>(heads_file.data());
+}
+
+RingMemberIndex::Bucket*
+RingMemberIndex::buckets() const
+{
+    return reinterpret_cast<Bucket*>(
+                heads_file.data() + sizeof(HeadsHeader));
+}
+
+crypto::hash*
+RingMemberIndex::block_hashes() const
+{
+    return reinterpret_cast<crypto::hash*>(blocks_file.data());
+}
+
+bool
+RingMemberIndex::reserve_records(uint64_t no_of_records)
+{
+    uint64_t needed = sizeof(RecordsHeader)
+                      + no_of_records * sizeof(Record);
+
+    if (records_file.size() >= needed)
+        return true;
+
+    return records_file.map(std::max(needed, records_file.size() * 2));
+}
+
+bool
+RingMemberIndex::reserve_blocks(uint64_t no_of_blocks)
+{
+    uint64_t needed = no_of_blocks * sizeof(crypto::hash);
+
+    if (blocks_file.size() >= needed)
+        return true;
+
+    return blocks_file.map(std::max(needed, blocks_file.size() * 2));
+}
+
+RingMemberIndex::Bucket*
+RingMemberIndex::find_bucket(uint64_t amount, uint64_t global_index) const
+{
+    uint64_t mask = heads_header()->capacity - 1;
+
+    uint64_t i = hash_index(amount, global_index) & mask;
+
+    Bucket* b = buckets();
+
+    // linear probing. buckets are never removed, so an empty
+    // one means the key is not there
+    while (b[i].head != 0
+           && (b[i].amount != amount || b[i].global_index != global_index))
+    {
+        i = (i + 1) & mask;
+    }
+
+    return &b[i];
+}
+
+bool
+RingMemberIndex::set_head(uint64_t amount,
+                          uint64_t global_index,
+                          uint64_t head)
+{
+    Bucket* bucket = find_bucket(amount, global_index);
+
+    if (bucket->head == 0)
+    {
+        // keep load factor below 0.7
+        if ((heads_header()->no_of_used + 1) * 10
+                > heads_header()->capacity * 7)
+        {
+            // all records, including the one for this
+            // head, are already in records.bin
+            return rebuild_heads(heads_header()->capacity * 2);
+        }
+
+        bucket->amount       = amount;
+        bucket->global_index = global_index;
+
+        ++heads_header()->no_of_used;
+    }
+
+    bucket->head = head;
+
+    return true;
+}
+
+void
+RingMemberIndex::drop_records_from(uint64_t no_of_records)
+{
+    // failed resize leaves files unmapped. mapping them
+    // with size 0 just maps what is already on disk
+    if ((records_file.size() == 0 && !records_file.map(0))
+            || (blocks_file.size() == 0 && !blocks_file.map(0)))
+    {
+        OMERROR << "Ring member index closed, cant remap its files";
+        is_open = false;
+        return;
+    }
+
+    records_header()->no_of_records = no_of_records;
+
+    // some heads can point to dropped records now
+    uint64_t capacity = heads_file.size() > 0
+                        ? heads_header()->capacity : 0;
+
+    if (!rebuild_heads(capacity))
+    {
+        OMERROR << "Ring member index closed, cant rebuild its heads";
+        is_open = false;
+    }
+}
+
+bool
+RingMemberIndex::rebuild_heads(uint64_t capacity)
+{
+    uint64_t n = records_header()->no_of_records;
+
+    capacity = next_pow2(std::max<uint64_t>(capacity, 1 << 16));
+
+    while (true)
+    {
+        heads_file.unmap();
+
+        try
+        {
+            bf::remove(heads_file.get_path());
+        }
+        catch (std::exception const& e)
+        {
+            OMERROR << "Cant remove " << heads_file.get_path()
+                    << ": " << e.what();
+            return false;
+        }
+
+        if (!heads_file.map(sizeof(HeadsHeader)
+                            + capacity * sizeof(Bucket)))
+            return false;
+
+        *heads_header() = {magic, capacity, 0, 0};
+
+        bool too_small {false};
+
+        for (uint64_t i = 0; i < n; ++i)
+        {
+            Record const& r = records()[i];
+
+            Bucket* bucket = find_bucket(r.amount, r.global_index);
+
+            if (bucket->head == 0)
+            {
+                if ((heads_header()->no_of_used + 1) * 10
+                        > capacity * 7)
+                {
+                    too_small = true;
+                    break;
+                }
+
+                bucket->amount       = r.amount;
+                bucket->global_index = r.global_index;
+
+                ++heads_header()->no_of_used;
+            }
+
+            // records are in order, so the last one wins
+            bucket->head = i + 1;
+        }
+
+        if (!too_small)
+            break;
+
+        capacity *= 2;
+    }
+
+    heads_header()->synced_records = n;
+
+    return true;
+}
+
+}
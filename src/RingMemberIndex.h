@@ -0,0 +1,184 @@
+#pragma once
+
+#include "src/monero_headers.h"
+#include "MappedFile.h"
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <atomic>
+
+namespace xmreg
+{
+
+using namespace cryptonote;
+using namespace crypto;
+using namespace std;
+
+/*
+ * On-disk reverse index of ring members.
+ *
+ * For each (amount, global output index) used as a ring member
+ * in any input, it keeps heights of blocks where this happened.
+ * With it, possible spendings of an account can be found by looking
+ * up its known outputs, rather than by going through every input of
+ * every tx in the blockchain.
+ *
+ * It is made of three memory-mapped files in the given directory:
+ *
+ *  - records.bin - append-only list of records (amount, global index,
+ *                  height, index of previous record with the same
+ *                  amount and global index). Since blocks are added in
+ *                  order, records are sorted by height.
+ *  - heads.bin   - open addressing hash table from (amount, global
+ *                  index) to its last record.
+ *  - blocks.bin  - hashes of indexed blocks, used to detect reorgs.
+ *
+ * amount is 0 for ringct inputs, same as in the blockchain.
+ * The index is built in small batches by a background thread launched
+ * in CurrentBlockchainStatus::monitor_blockchain, and its top blocks
+ * are removed on reorgs.
+ */
+class RingMemberIndex
+{
+public:
+
+    RingMemberIndex(string _dir);
+
+    // opens existing index files or creates new ones
+    virtual bool
+    open();
+
+    // blocks below this height are in the index
+    virtual uint64_t
+    get_indexed_height();
+
+    virtual bool
+    get_block_hash(uint64_t height, crypto::hash& blk_hash);
+
+    // adds ring members of all inputs in the given txs.
+    // height must be equal to get_indexed_height()
+    virtual bool
+    add_block(uint64_t height,
+              crypto::hash const& blk_hash,
+              vector<transaction> const& txs);
+
+    // removes blocks with heights equal or larger than the given one
+    virtual void
+    pop_blocks(uint64_t height);
+
+    // increased each time blocks are popped. users of find
+    // compare it with its previous value to know that
+    // heights they found before can be wrong now
+    virtual uint64_t
+    get_no_of_pops() const
+    {
+        return no_of_pops;
+    }
+
+    // heights of blocks in which the given output was used as
+    // a ring member, from the highest one down to min_height
+    virtual vector<uint64_t>
+    find(uint64_t amount, uint64_t global_index, uint64_t min_height = 0);
+
+    virtual void
+    flush();
+
+    virtual ~RingMemberIndex();
+
+private:
+
+    static constexpr uint64_t magic {0x78726d69646b7830};
+
+    static constexpr uint64_t no_record {~uint64_t {0}};
+
+    struct Record
+    {
+        uint64_t amount;
+        uint64_t global_index;
+        uint64_t height;
+        uint64_t prev;
+    };
+
+    struct RecordsHeader
+    {
+        uint64_t magic;
+        uint64_t no_of_records;
+        uint64_t indexed_height;
+    };
+
+    struct Bucket
+    {
+        uint64_t amount;
+        uint64_t global_index;
+
+        // index of last record + 1, so that 0 means empty bucket
+        uint64_t head;
+    };
+
+    struct HeadsHeader
+    {
+        uint64_t magic;
+        uint64_t capacity;
+        uint64_t no_of_used;
+
+        // no_of_records for which heads are up to date.
+        // if it differs from records, heads are rebuilt
+        uint64_t synced_records;
+    };
+
+    RecordsHeader*
+    records_header() const;
+
+    Record*
+    records() const;
+
+    HeadsHeader*
+    heads_header() const;
+
+    Bucket*
+    buckets() const;
+
+    crypto::hash*
+    block_hashes() const;
+
+    bool
+    reserve_records(uint64_t no_of_records);
+
+    bool
+    reserve_blocks(uint64_t no_of_blocks);
+
+    // bucket with the given key, or empty bucket
+    // where it should be inserted
+    Bucket*
+    find_bucket(uint64_t amount, uint64_t global_index) const;
+
+    bool
+    set_head(uint64_t amount, uint64_t global_index, uint64_t head);
+
+    // drops records added after the first no_of_records ones
+    // and rebuilds heads without them. used when a block
+    // fails to be added, so that it leaves nothing behind
+    void
+    drop_records_from(uint64_t no_of_records);
+
+    // creates new heads table with the given capacity
+    // from all records
+    bool
+    rebuild_heads(uint64_t capacity);
+
+    string dir;
+
+    MappedFile records_file;
+    MappedFile heads_file;
+    MappedFile blocks_file;
+
+    bool is_open {false};
+
+    atomic<uint64_t> no_of_pops {0};
+
+    mutex index_mtx;
+};
+
+}
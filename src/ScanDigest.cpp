@@ -0,0 +1,507 @@
+#include "ScanDigest.h"
+#include "TxSearch.h"
+
+#include "om_log.h"
+
+#include <boost/filesystem.hpp>
+
+#include <cstring>
+
+namespace xmreg
+{
+
+namespace bf = boost::filesystem;
+
+constexpr uint64_t ScanDigest::magic;
+
+namespace
+{
+
+enum : uint8_t {digest_txin_gen = 0, digest_txin_to_key = 1};
+
+void
+put_varint(string& buf, uint64_t v)
+{
+    while (v >= 0x80)
+    {
+        buf.push_back(static_cast<char>((v & 0x7f) | 0x80));
+        v >>= 7;
+    }
+
+    buf.push_back(static_cast<char>(v));
+}
+
+template <typename T>
+void
+put_pod(string& buf, T const& pod)
+{
+    buf.append(reinterpret_cast<char const*>(&pod), sizeof(T));
+}
+
+// reads what put_varint and put_pod wrote. throws if
+// data ends too early, which means the digest is corrupted
+class DigestReader
+{
+public:
+
+    DigestReader(char const* _p, char const* _end)
+        : p {_p}, end {_end}
+    {}
+
+    uint64_t
+    varint()
+    {
+        uint64_t v {0};
+
+        for (int shift = 0; shift < 64; shift += 7)
+        {
+            check(1);
+
+            uint8_t b = static_cast<uint8_t>(*p++);
+
+            v |= static_cast<uint64_t>(b & 0x7f) << shift;
+
+            if (!(b & 0x80))
+                return v;
+        }
+
+        throw std::runtime_error("Invalid varint in scan digest");
+    }
+
+    template <typename T>
+    void
+    pod(T& out)
+    {
+        check(sizeof(T));
+        std::memcpy(&out, p, sizeof(T));
+        p += sizeof(T);
+    }
+
+    void
+    bytes(size_t n, vector<uint8_t>& out)
+    {
+        check(n);
+        out.assign(p, p + n);
+        p += n;
+    }
+
+private:
+
+    void
+    check(size_t n) const
+    {
+        if (static_cast<size_t>(end - p) < n)
+            throw std::runtime_error("Unexpected end of scan digest");
+    }
+
+    char const* p;
+    char const* end;
+};
+
+// returns false if tx has outputs or inputs we dont keep
+bool
+write_tx(string& buf, crypto::hash const& tx_hash, transaction const& tx)
+{
+    put_pod(buf, tx_hash);
+
+    put_varint(buf, tx.version);
+    put_varint(buf, tx.unlock_time);
+
+    put_varint(buf, tx.extra.size());
+    buf.append(tx.extra.begin(), tx.extra.end());
+
+    put_varint(buf, tx.vin.size());
+
+    for (auto const& in: tx.vin)
+    {
+        if (in.type() == typeid(txin_gen))
+        {
+            buf.push_back(digest_txin_gen);
+            put_varint(buf, boost::get<txin_gen>(in).height);
+        }
+        else if (in.type() == typeid(txin_to_key))
+        {
+            auto const& in_key = boost::get<txin_to_key>(in);
+
+            buf.push_back(digest_txin_to_key);
+            put_varint(buf, in_key.amount);
+            put_pod(buf, in_key.k_image);
+
+            vector<uint64_t> absolute_offsets
+                    = relative_output_offsets_to_absolute(
+                            in_key.key_offsets);
+
+            put_varint(buf, absolute_offsets.size());
+
+            for (uint64_t offset: absolute_offsets)
+                put_varint(buf, offset);
+        }
+        else
+        {
+            return false;
+        }
+    }
+
+    put_varint(buf, tx.vout.size());
+
+    for (auto const& out: tx.vout)
+    {
+        if (out.target.type() != typeid(txout_to_key))
+            return false;
+
+        put_varint(buf, out.amount);
+        put_pod(buf, boost::get<txout_to_key>(out.target).key);
+    }
+
+    if (tx.version < 2)
+        return true;
+
+    rct::rctSig const& rv = tx.rct_signatures;
+
+    buf.push_back(static_cast<char>(rv.type));
+    put_varint(buf, rv.txnFee);
+
+    put_varint(buf, rv.ecdhInfo.size());
+
+    for (auto const& ecdh: rv.ecdhInfo)
+        put_pod(buf, ecdh);
+
+    put_varint(buf, rv.outPk.size());
+
+    for (auto const& out_pk: rv.outPk)
+        put_pod(buf, out_pk);
+
+    return true;
+}
+
+void
+read_tx(DigestReader& reader, crypto::hash& tx_hash, transaction& tx)
+{
+    reader.pod(tx_hash);
+
+    tx.version     = reader.varint();
+    tx.unlock_time = reader.varint();
+
+    reader.bytes(reader.varint(), tx.extra);
+
+    uint64_t no_of_inputs = reader.varint();
+
+    tx.vin.reserve(no_of_inputs);
+
+    for (uint64_t i = 0; i < no_of_inputs; ++i)
+    {
+        uint8_t in_type;
+
+        reader.pod(in_type);
+
+        if (in_type == digest_txin_gen)
+        {
+            txin_gen in_gen;
+            in_gen.height = reader.varint();
+            tx.vin.push_back(in_gen);
+        }
+        else if (in_type == digest_txin_to_key)
+        {
+            txin_to_key in_key;
+
+            in_key.amount = reader.varint();
+            reader.pod(in_key.k_image);
+
+            vector<uint64_t> absolute_offsets(reader.varint());
+
+            for (auto& offset: absolute_offsets)
+                offset = reader.varint();
+
+            in_key.key_offsets = absolute_output_offsets_to_relative(
+                        absolute_offsets);
+
+            tx.vin.push_back(in_key);
+        }
+        else
+        {
+            throw std::runtime_error("Invalid input type in scan digest");
+        }
+    }
+
+    uint64_t no_of_outputs = reader.varint();
+
+    tx.vout.resize(no_of_outputs);
+
+    for (auto& out: tx.vout)
+    {
+        txout_to_key out_key;
+
+        out.amount = reader.varint();
+        reader.pod(out_key.key);
+
+        out.target = out_key;
+    }
+
+    if (tx.version < 2)
+        return;
+
+    rct::rctSig& rv = tx.rct_signatures;
+
+    reader.pod(rv.type);
+    rv.txnFee = reader.varint();
+
+    rv.ecdhInfo.resize(reader.varint());
+
+    for (auto& ecdh: rv.ecdhInfo)
+        reader.pod(ecdh);
+
+    rv.outPk.resize(reader.varint());
+
+    for (auto& out_pk: rv.outPk)
+        reader.pod(out_pk);
+}
+
+}
+
+ScanDigest::ScanDigest(string _dir)
+    : dir {_dir}
+{
+    blocks_file.set_path((bf::path(dir) / "blocks.bin").string());
+    data_file.set_path((bf::path(dir) / "data.bin").string());
+}
+
+bool
+ScanDigest::open()
+{
+    std::lock_guard<std::mutex> lck (digest_mtx);
+
+    try
+    {
+        bf::create_directories(dir);
+    }
+    catch (std::exception const& e)
+    {
+        OMERROR << "Cant create " << dir << ": " << e.what();
+        return false;
+    }
+
+    bool new_digest = !bf::exists(blocks_file.get_path());
+
+    if (!blocks_file.map(sizeof(Header) + (1 << 16) * sizeof(BlockEntry)))
+        return false;
+
+    if (new_digest)
+    {
+        *header() = {magic, 0, 0};
+    }
+    else if (header()->magic != magic)
+    {
+        OMERROR << blocks_file.get_path() << " is not a scan digest";
+        return false;
+    }
+
+    // header is updated after the data is written, so anything
+    // in data.bin past data_size, e.g., due to a crash, is ignored
+    if (!data_file.map(std::max<uint64_t>(header()->data_size, 1 << 24)))
+        return false;
+
+    is_open = true;
+
+    OMINFO << "Scan digest opened. Blocks: " << header()->no_of_blocks
+           << ", size: " << header()->data_size / (1024 * 1024) << " MB";
+
+    return true;
+}
+
+uint64_t
+ScanDigest::get_height()
+{
+    std::lock_guard<std::mutex> lck (digest_mtx);
+    return is_open ? header()->no_of_blocks : 0;
+}
+
+bool
+ScanDigest::get_block_hash(uint64_t height, crypto::hash& blk_hash)
+{
+    std::lock_guard<std::mutex> lck (digest_mtx);
+
+    if (!is_open || height >= header()->no_of_blocks)
+        return false;
+
+    blk_hash = block_entries()[height].blk_hash;
+
+    return true;
+}
+
+bool
+ScanDigest::add_block(uint64_t height,
+                      crypto::hash const& blk_hash,
+                      uint64_t timestamp,
+                      vector<crypto::hash> const& txs_hashes,
+                      vector<transaction> const& txs)
+{
+    if (txs_hashes.size() != txs.size())
+        return false;
+
+    // serialize outside of the lock, so that
+    // reading windows is not blocked by it
+    string buf;
+    bool complete {true};
+
+    for (size_t i = 0; i < txs.size() && complete; ++i)
+        complete = write_tx(buf, txs_hashes[i], txs[i]);
+
+    if (!complete)
+    {
+        OMVLOG1 << "Block " << height << " has txs which cant be "
+                << "kept in scan digest. It will be read from lmdb.";
+        buf.clear();
+    }
+
+    std::lock_guard<std::mutex> lck (digest_mtx);
+
+    if (!is_open || height != header()->no_of_blocks)
+        return false;
+
+    uint64_t offset = header()->data_size;
+
+    if (!reserve_data(offset + buf.size())
+            || !reserve_blocks(height + 1))
+        return false;
+
+    std::memcpy(data_file.data() + offset, buf.data(), buf.size());
+
+    block_entries()[height] = {blk_hash, timestamp, offset, buf.size(),
+                               txs.size(), complete};
+
+    header()->data_size = offset + buf.size();
+    header()->no_of_blocks = height + 1;
+
+    return true;
+}
+
+void
+ScanDigest::pop_blocks(uint64_t height)
+{
+    std::lock_guard<std::mutex> lck (digest_mtx);
+
+    if (!is_open || height >= header()->no_of_blocks)
+        return;
+
+    // data is appended block by block, so we just cut it
+    header()->data_size = block_entries()[height].offset;
+    header()->no_of_blocks = height;
+}
+
+bool
+ScanDigest::get_window(uint64_t h1, uint64_t h2, ScanWindow& window)
+{
+    std::lock_guard<std::mutex> lck (digest_mtx);
+
+    if (!is_open || h1 > h2 || h2 >= header()->no_of_blocks)
+        return false;
+
+    uint64_t no_of_txs {0};
+
+    for (uint64_t height = h1; height <= h2; ++height)
+    {
+        if (!block_entries()[height].complete)
+            return false;
+
+        no_of_txs += block_entries()[height].no_of_txs;
+    }
+
+    window.h1 = h1;
+    window.h2 = h2;
+    window.last_block_timestamp = block_entries()[h2].timestamp;
+
+    window.txs_hashes.clear();
+    window.txs.clear();
+    window.txs_data.clear();
+
+    window.txs_hashes.reserve(no_of_txs);
+    window.txs.reserve(no_of_txs);
+    window.txs_data.reserve(no_of_txs);
+
+    try
+    {
+        for (uint64_t height = h1; height <= h2; ++height)
+        {
+            BlockEntry const& entry = block_entries()[height];
+
+            char const* p = data_file.data() + entry.offset;
+
+            DigestReader reader(p, p + entry.size);
+
+            for (uint64_t i = 0; i < entry.no_of_txs; ++i)
+            {
+                crypto::hash tx_hash;
+                transaction tx;
+
+                read_tx(reader, tx_hash, tx);
+
+                window.txs_hashes.push_back(tx_hash);
+                window.txs.push_back(std::move(tx));
+
+                // miner tx is always first, same as
+                // in get_txs_in_blocks
+                window.txs_data.emplace_back(height, entry.timestamp,
+                                             i == 0);
+            }
+        }
+    }
+    catch (std::exception const& e)
+    {
+        OMERROR << "Cant read blocks from " << h1 << " to " << h2
+                << " from scan digest: " << e.what();
+        return false;
+    }
+
+    return true;
+}
+
+void
+ScanDigest::flush()
+{
+    std::lock_guard<std::mutex> lck (digest_mtx);
+
+    // data first, so that header never points
+    // to data which was not saved
+    data_file.flush();
+    blocks_file.flush();
+}
+
+ScanDigest::~ScanDigest()
+{
+    flush();
+}
+
+ScanDigest::Header*
+ScanDigest::header() const
+{
+    return reinterpret_cast<Header*>(blocks_file.data());
+}
+
+ScanDigest::BlockEntry*
+ScanDigest::block_entries() const
+{
+    return reinterpret_cast<BlockEntry*>(
+                blocks_file.data() + sizeof(Header));
+}
+
+bool
+ScanDigest::reserve_blocks(uint64_t no_of_blocks)
+{
+    uint64_t needed = sizeof(Header) + no_of_blocks * sizeof(BlockEntry);
+
+    if (blocks_file.size() >= needed)
+        return true;
+
+    return blocks_file.map(std::max(needed, blocks_file.size() * 2));
+}
+
+bool
+ScanDigest::reserve_data(uint64_t data_size)
+{
+    if (data_file.size() >= data_size)
+        return true;
+
+    return data_file.map(std::max(data_size, data_file.size() * 2));
+}
+
+}
@@ -0,0 +1,137 @@
+#pragma once
+
+#include "src/monero_headers.h"
+#include "MappedFile.h"
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <mutex>
+
+namespace xmreg
+{
+
+using namespace cryptonote;
+using namespace crypto;
+using namespace std;
+
+struct ScanWindow;
+
+/*
+ * Compact on-disk copy of the blockchain with only the parts
+ * of txs needed for finding outputs and inputs of accounts.
+ *
+ * For each tx it keeps its hash, version, unlock time, extra (tx public
+ * key, additional public keys and payment id), output keys and amounts,
+ * ringct type, ecdh info and outPk commitments, and key images of inputs
+ * with absolute offsets of their ring members. Signatures, range proofs
+ * and the rest of the prunable data are not kept, so scanning from
+ * the digest avoids reading and deserializing full txs from lmdb, which
+ * is what slows down imports of old accounts the most.
+ *
+ * It is made of two memory-mapped files in the given directory:
+ *
+ *  - blocks.bin - header and, for each block, its hash, timestamp
+ *                 and position of its txs in data.bin
+ *  - data.bin   - append-only serialized txs, block by block
+ *
+ * Txs read from the digest are pruned, i.e., everything needed to
+ * identify outputs and inputs and to calculate prefix hash is there,
+ * but they must not be used where full txs are needed. Their hashes
+ * are read from the digest as well, as they cant be calculated
+ * from pruned txs.
+ *
+ * The digest is built by a background thread launched in
+ * CurrentBlockchainStatus::monitor_blockchain, and its top blocks
+ * are removed on reorgs.
+ */
+class ScanDigest
+{
+public:
+
+    ScanDigest(string _dir);
+
+    // opens existing digest files or creates new ones
+    virtual bool
+    open();
+
+    // blocks below this height are in the digest
+    virtual uint64_t
+    get_height();
+
+    virtual bool
+    get_block_hash(uint64_t height, crypto::hash& blk_hash);
+
+    // adds the given block with its txs (miner tx first), as
+    // returned by CurrentBlockchainStatus::get_txs_in_blocks.
+    // height must be equal to get_height()
+    virtual bool
+    add_block(uint64_t height,
+              crypto::hash const& blk_hash,
+              uint64_t timestamp,
+              vector<crypto::hash> const& txs_hashes,
+              vector<transaction> const& txs);
+
+    // removes blocks with heights equal or larger than the given one
+    virtual void
+    pop_blocks(uint64_t height);
+
+    // fills the window with pruned txs of blocks from h1 to h2.
+    // returns false if not all of them are in the digest, or
+    // some of them could not be digested
+    virtual bool
+    get_window(uint64_t h1, uint64_t h2, ScanWindow& window);
+
+    virtual void
+    flush();
+
+    virtual ~ScanDigest();
+
+private:
+
+    static constexpr uint64_t magic {0x78726d7364677830};
+
+    struct Header
+    {
+        uint64_t magic;
+        uint64_t no_of_blocks;
+        uint64_t data_size;
+    };
+
+    struct BlockEntry
+    {
+        crypto::hash blk_hash;
+        uint64_t timestamp;
+        uint64_t offset;
+        uint64_t size;
+        uint64_t no_of_txs;
+
+        // some txs in the block have outputs or inputs
+        // of types which we dont keep. such blocks are
+        // always read from lmdb
+        uint64_t complete;
+    };
+
+    Header*
+    header() const;
+
+    BlockEntry*
+    block_entries() const;
+
+    bool
+    reserve_blocks(uint64_t no_of_blocks);
+
+    bool
+    reserve_data(uint64_t data_size);
+
+    string dir;
+
+    MappedFile blocks_file;
+    MappedFile data_file;
+
+    bool is_open {false};
+
+    mutex digest_mtx;
+};
+
+}
@@ -0,0 +1,260 @@
+#include "ScanWorkerPool.h"
+
+namespace xmreg
+{
+
+void
+ScanTaskGroup::add(size_t no_of_tasks)
+{
+    std::lock_guard<std::mutex> lck (mtx);
+    pending += no_of_tasks;
+}
+
+void
+ScanTaskGroup::done()
+{
+    {
+        std::lock_guard<std::mutex> lck (mtx);
+
+        if (pending > 0)
+            --pending;
+    }
+
+    cv.notify_all();
+}
+
+void
+ScanTaskGroup::wait()
+{
+    std::unique_lock<std::mutex> lck (mtx);
+    cv.wait(lck, [this]() {return pending == 0;});
+}
+
+bool
+ScanTaskGroup::finished()
+{
+    std::lock_guard<std::mutex> lck (mtx);
+    return pending == 0;
+}
+
+
+ScanWorkerPool::ScanWorkerPool(size_t no_of_workers)
+{
+    if (no_of_workers == 0)
+        no_of_workers = std::max(std::thread::hardware_concurrency(), 1u);
+
+    for (size_t i = 0; i < no_of_workers; ++i)
+        workers.push_back(std::make_unique<Worker>());
+
+    for (size_t i = 0; i < no_of_workers; ++i)
+        threads.emplace_back(&ScanWorkerPool::worker_loop, this, i);
+
+    OMINFO << "Scan worker pool started with "
+           << no_of_workers << " workers";
+}
+
+void
+ScanWorkerPool::submit(task_t task)
+{
+    size_t idx = next_worker++ % workers.size();
+
+    // counted before the task is visible to workers, as otherwise
+    // a worker could take it and decrease no_of_queued below zero
+    {
+        std::lock_guard<std::mutex> lck (wait_mtx);
+        ++no_of_queued;
+    }
+
+    {
+        std::lock_guard<std::mutex> lck (workers[idx]->mtx);
+        workers[idx]->tasks.push_back(std::move(task));
+    }
+
+    wait_cv.notify_one();
+}
+
+void
+ScanWorkerPool::submit(task_t task, shared_ptr<ScanTaskGroup> group)
+{
+    group->add();
+
+    submit([task = std::move(task), group]()
+    {
+        try
+        {
+            task();
+        }
+        catch (...)
+        {
+            group->done();
+            throw;
+        }
+
+        group->done();
+    });
+}
+
+void
+ScanWorkerPool::parallel_for(size_t n, std::function<void(size_t)> f)
+{
+    if (n == 0)
+        return;
+
+    struct Loop
+    {
+        std::function<void(size_t)> f;
+
+        size_t n {0};
+        std::atomic<size_t> next_i {0};
+
+        // guarded by mtx
+        size_t no_of_finished {0};
+        std::exception_ptr eptr;
+
+        mutex mtx;
+        condition_variable cv;
+
+        // takes indices until there are none left
+        void
+        run()
+        {
+            size_t i;
+
+            while ((i = next_i++) < n)
+            {
+                std::exception_ptr e;
+
+                try
+                {
+                    f(i);
+                }
+                catch (...)
+                {
+                    e = std::current_exception();
+                }
+
+                {
+                    std::lock_guard<std::mutex> lck (mtx);
+
+                    if (e && !eptr)
+                        eptr = e;
+
+                    ++no_of_finished;
+                }
+
+                cv.notify_all();
+            }
+        }
+    };
+
+    auto loop = make_shared<Loop>();
+
+    loop->f = std::move(f);
+    loop->n = n;
+
+    // helpers which start after all indices were taken
+    // just return
+    size_t no_of_helpers = std::min(n - 1, workers.size());
+
+    for (size_t i = 0; i < no_of_helpers; ++i)
+        submit([loop]() {loop->run();});
+
+    loop->run();
+
+    std::unique_lock<std::mutex> lck (loop->mtx);
+
+    loop->cv.wait(lck, [&loop]() {return loop->no_of_finished == loop->n;});
+
+    if (loop->eptr)
+        std::rethrow_exception(loop->eptr);
+}
+
+void
+ScanWorkerPool::worker_loop(size_t idx)
+{
+    while (true)
+    {
+        task_t task;
+
+        if (pop_task(idx, task) || steal_task(idx, task))
+        {
+            --no_of_queued;
+
+            try
+            {
+                task();
+            }
+            catch (std::exception const& e)
+            {
+                OMERROR << "Exception in scan worker: " << e.what();
+            }
+            catch (...)
+            {
+                OMERROR << "Exception in scan worker!";
+            }
+
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lck (wait_mtx);
+
+        wait_cv.wait(lck, [this]() {return done || no_of_queued > 0;});
+
+        // finish all queued tasks before quiting
+        if (done && no_of_queued == 0)
+            return;
+    }
+}
+
+bool
+ScanWorkerPool::pop_task(size_t idx, task_t& task)
+{
+    Worker& worker = *workers[idx];
+
+    std::lock_guard<std::mutex> lck (worker.mtx);
+
+    if (worker.tasks.empty())
+        return false;
+
+    task = std::move(worker.tasks.front());
+    worker.tasks.pop_front();
+
+    return true;
+}
+
+bool
+ScanWorkerPool::steal_task(size_t idx, task_t& task)
+{
+    for (size_t i = 1; i < workers.size(); ++i)
+    {
+        Worker& victim = *workers[(idx + i) % workers.size()];
+
+        std::lock_guard<std::mutex> lck (victim.mtx);
+
+        if (victim.tasks.empty())
+            continue;
+
+        task = std::move(victim.tasks.back());
+        victim.tasks.pop_back();
+
+        return true;
+    }
+
+    return false;
+}
+
+ScanWorkerPool::~ScanWorkerPool()
+{
+    {
+        std::lock_guard<std::mutex> lck (wait_mtx);
+        done = true;
+    }
+
+    wait_cv.notify_all();
+
+    for (auto& t: threads)
+        if (t.joinable())
+            t.join();
+}
+
+}
@@ -0,0 +1,132 @@
+#pragma once
+
+#include "om_log.h"
+
+#include <deque>
+#include <algorithm>
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <memory>
+#include <functional>
+#include <exception>
+#include <condition_variable>
+
+namespace xmreg
+{
+
+using namespace std;
+
+/*
+ * Counts tasks submitted to ScanWorkerPool, so that
+ * one can wait for all of them to finish.
+ */
+class ScanTaskGroup
+{
+public:
+
+    void
+    add(size_t no_of_tasks = 1);
+
+    void
+    done();
+
+    void
+    wait();
+
+    bool
+    finished();
+
+private:
+    size_t pending {0};
+
+    mutex mtx;
+    condition_variable cv;
+};
+
+/*
+ * Fixed number of worker threads executing scan tasks.
+ *
+ * Before, every account had its own TxSearch thread which mostly
+ * slept. Now scanning of a window for a given account is a task,
+ * and its state (searched_blk_no, known outputs, etc.) lives in its
+ * TxSearch object, so a task can be executed by any worker.
+ *
+ * Each worker has its own deque of tasks. Tasks are distributed
+ * round robin, and a worker which runs out of its tasks steals
+ * from the back of other workers' deques. This is because scanning
+ * a window for an account with many txs can take much longer than
+ * for others.
+ */
+class ScanWorkerPool
+{
+public:
+
+    using task_t = std::function<void()>;
+
+    // no_of_workers of 0 means number of cpu cores
+    ScanWorkerPool(size_t no_of_workers = 0);
+
+    virtual void
+    submit(task_t task);
+
+    // submits the task and marks it done in
+    // the group when it finishes
+    virtual void
+    submit(task_t task, shared_ptr<ScanTaskGroup> group);
+
+    // calls f(i) for i in [0, n) using the workers. The calling
+    // thread also executes f, and it returns when all calls
+    // finished. It can be called from within a task, as the caller
+    // never waits for tasks which have not started yet.
+    // First exception thrown by f is rethrown here.
+    virtual void
+    parallel_for(size_t n, std::function<void(size_t)> f);
+
+    virtual size_t
+    size() const
+    {
+        return workers.size();
+    }
+
+    // finishes queued tasks and joins the workers
+    virtual ~ScanWorkerPool();
+
+private:
+
+    struct Worker
+    {
+        deque<task_t> tasks;
+        mutex mtx;
+    };
+
+    void
+    worker_loop(size_t idx);
+
+    // takes task from the front of its own deque
+    bool
+    pop_task(size_t idx, task_t& task);
+
+    // takes task from the back of other workers' deques
+    bool
+    steal_task(size_t idx, task_t& task);
+
+    vector<unique_ptr<Worker>> workers;
+    vector<std::thread> threads;
+
+    std::atomic<size_t> next_worker {0};
+
+    // no of tasks in all deques. guarded by wait_mtx
+    // when increased, so that workers dont miss it. its
+    // increased before a task is pushed, so it never
+    // goes below the number of tasks in the deques
+    std::atomic<size_t> no_of_queued {0};
+
+    bool done {false};
+
+    mutex wait_mtx;
+    condition_variable wait_cv;
+};
+
+}
@@ -50,6 +50,8 @@ TxSearch::TxSearch(XmrAccount const& _acc,
     // this accont
     searched_blk_no = acc->scanned_block_height;
 
+    bump_state_version();
+
     last_ping_timestamp = 0s;
 
     address_prefix = acc->address.substr(0, 6);
@@ -58,115 +60,40 @@ TxSearch::TxSearch(XmrAccount const& _acc,
 }
 
 void
-TxSearch::operator()()
+TxSearch::scan_window(ScanWindow const& window, ScanWorkerPool* workers)
 {
 
-seconds current_timestamp = get_current_timestamp();
-
-last_ping_timestamp = current_timestamp;
+// searched_blk_no could have been changed since BlockScanner grouped
+// us with this window, e.g., due to import. In this case just
+// skip the window. The scanner will pick it up later with new value.
+searched_block_got_updated = false;
 
-uint64_t blocks_lookahead
-        = current_bc_status->get_bc_setup().blocks_search_lookahead;
+uint64_t h1 = searched_blk_no;
+uint64_t h2 = window.h2;
 
+if (!continue_search || h1 < window.h1 || h1 > h2)
+    return;
 
 auto current_bc_status_ptr = current_bc_status.get();
 
 uint64_t account_id = acc->id.data;
 
-searching_is_ongoing = true;
-
 MicroCoreAdapter mcore_addapter {current_bc_status_ptr};
 
 // we put everything in massive catch, as there are plenty ways in which
 // an exceptions can be thrown here. Mostly from mysql.
-// but because this is detatch thread, we cant catch them in main thread.
-// program will blow up if exception is thrown. need to handle exceptions
-// here.
+// the scanner is shared by all accounts, so exception here should
+// only stop this account, not the others.
 try
 {
-while(continue_search)
-{            
-
-seconds loop_timestamp {current_timestamp};
-
-uint64_t last_block_height = current_bc_status->current_height;
-
-uint64_t h1 = searched_blk_no;
-uint64_t h2 = std::min(h1 + blocks_lookahead - 1, last_block_height);
-
-vector<block> blocks;
-
-blocks = current_bc_status->get_blocks_range(h1, h2);
-
-if (blocks.empty())
-{
-
-    if (h1 <= h2)
-    {
-        OMERROR << address_prefix  << ": cant get blocks from " << h1
-                << " to " << h2;
-        stop();
-    }
-    else
-    {
-        OMVLOG1 << address_prefix << ": waiting for new block. "
-               << "Last scanned was " << h2;
-    }
-
-    std::this_thread::sleep_for(
-            std::chrono::seconds(
-                    current_bc_status->get_bc_setup()
-                    .refresh_block_status_every)
-    );
-
-    loop_timestamp = get_current_timestamp();
 
-    // if thread has lived longer than thread_search_li
-    // without last_ping_timestamp being updated,
-    // stop the thread
-    if (loop_timestamp - last_ping_timestamp > thread_search_life)
-    {
-        OMINFO << address_prefix
-                  + ": search thread stopped.";
-        stop();
-    }
-
-    // update current_height of blockchain, as maybe top block(s)
-    // were dropped due to reorganization.
-    //CurrentBlockchainStatus::update_current_blockchain_height();
-
-    // if any txs that we already indexed got orphaned as a
-    // consequence of this
-    // MySqlAccounts::select_txs_for_account_spendability_check
-    // should
-    // update database accordingly when get_address_txs is executed.
-
-    continue;
-}
-
-OMVLOG2 << address_prefix  + ": analyzing "
-        << blocks.size() << " blocks from "
+OMVLOG2 << address_prefix  + ": analyzing blocks from "
         << h1 << " to " << h2
-        << " out of " << last_block_height << " blocks";
+        << " out of " << current_bc_status->current_height << " blocks";
 
-vector<crypto::hash> txs_hashes_from_blocks;
-vector<transaction> txs_in_blocks;
-vector<CurrentBlockchainStatus::txs_tuple_t> txs_data;
-
-if (!current_bc_status->get_txs_in_blocks(blocks,
-                                          txs_hashes_from_blocks,
-                                          txs_in_blocks,
-                                          txs_data))
-{
-    OMERROR << address_prefix
-               + ": cant get tx in blocks from "
-            << h1 << " to " << h2;
-    return;
-}
-
-// we will only create mysql DateTime object once, anything is found
-// in a given block;
-unique_ptr<DateTime> blk_timestamp_mysql_format;
+auto const& txs_hashes_from_blocks = window.txs_hashes;
+auto const& txs_in_blocks          = window.txs;
+auto const& txs_data               = window.txs_data;
 
 // searching for our incoming and outgoing xmr has two components.
 //
@@ -185,443 +112,435 @@ unique_ptr<DateTime> blk_timestamp_mysql_format;
 // that we think are yours, and the frontend, because it has spend key,
 // can filter out false positives.
 
-size_t tx_idx {0};
-
-// grab a mysql connection from pool to use for transactions
-    auto conn = MySqlConnectionPool::get().grab_shared();
-
-for (auto const& tx_tuple: txs_data)
-{
-    crypto::hash const& tx_hash = txs_hashes_from_blocks[tx_idx];
-    transaction const& tx       = txs_in_blocks[tx_idx++];
-    uint64_t blk_height         = std::get<0>(tx_tuple);
-    uint64_t blk_timestamp      = std::get<1>(tx_tuple);
-    bool is_coinbase            = std::get<2>(tx_tuple);
-    bool is_rct                 = (tx.version == 2);
-    uint8_t rct_type            = (is_rct ? tx.rct_signatures.type : 0);
+// identification is done first for all txs in the window, in
+// parallel if we have workers. Then the rows are prepared in block
+// order, same as before, and written to mysql in one go for
+// the whole window.
 
+using outputs_identified_t
+    = std::decay_t<decltype(std::declval<Output&>().get())>;
 
-    // Class that is responsible for identification of our outputs
-    // and inputs in a given tx.
+// window can start before our searched_blk_no when
+// it is shared with other accounts
+vector<size_t> txs_to_scan;
 
-    auto identifier = make_identifier(tx,
-                        make_unique<Output>(&address, &viewkey),
-                        make_unique<Input>(&address, &viewkey,
-                                           &known_outputs_keys,
-                                           &mcore_addapter));
-    identifier.identify();
+for (size_t i = 0; i < txs_data.size(); ++i)
+    if (std::get<0>(txs_data[i]) >= h1)
+        txs_to_scan.push_back(i);
 
-    // flag indicating whether the txs in the given block are
-    // spendable.
-    // this is true when block number is more than 10 blocks
-    // from current blockchain height.
-    // if tx.unlock_time is not given (its value is 0), we set it
-    // here. For coinbase its always given, so no need to check
-    // for that
+vector<outputs_identified_t> outputs_identified_in_txs(txs_in_blocks.size());
+vector<vector<IdentifiedInput>> inputs_identified_in_txs(txs_in_blocks.size());
+vector<public_key> tx_pub_keys(txs_in_blocks.size());
 
-    uint64_t tx_unlock_time = tx.unlock_time;
+// amount specific (i.e., global) indices of outputs,
+// only for txs in which we found our outputs
+vector<vector<uint64_t>> amount_specific_indices_in_txs(
+        txs_in_blocks.size());
 
-    if (tx_unlock_time == 0)
-        tx_unlock_time = blk_height
-            + CRYPTONOTE_DEFAULT_TX_SPENDABLE_AGE;
+bool spend_detection_by_global_index
+        = current_bc_status->get_bc_setup()
+            .spend_detection_by_global_index;
 
-    bool is_spendable = current_bc_status->is_tx_unlocked(
-            tx_unlock_time, blk_height);
+auto for_each_tx = [&](auto const& f)
+{
+    if (workers)
+        workers->parallel_for(txs_to_scan.size(),
+                              [&](size_t i) {f(txs_to_scan[i]);});
+    else
+        for (size_t i: txs_to_scan)
+            f(i);
+};
 
-    // this is id of txs in lmdb blockchain table.
-    // it will be used mostly to sort txs in the frontend.
-    uint64_t blockchain_tx_id {0};
+// FIRST, outputs. they dont depend on anything, so each tx
+// can be done independently.
+for_each_tx([&](size_t i)
+{
+    auto identifier = make_identifier(txs_in_blocks[i],
+                        make_unique<Output>(&address, &viewkey));
+    identifier.identify();
 
-    // FIRSt step.
-    //
-    //oi_identification.identify_outputs();
-    auto const& outputs_identified
-        = identifier.get<Output>()->get();
+    outputs_identified_in_txs[i] = identifier.get<Output>()->get();
+    tx_pub_keys[i] = identifier.get_tx_pub_key();
+});
 
-    auto total_received = calc_total_xmr(outputs_identified);
+for (size_t i: txs_to_scan)
+{
+    if (outputs_identified_in_txs[i].empty())
+        continue;
 
-    vector<uint64_t> amount_specific_indices;
+    if (!current_bc_status->get_amount_specific_indices(
+            txs_hashes_from_blocks[i], amount_specific_indices_in_txs[i]))
+    {
+        OMERROR << address_prefix
+                   + ": cant get_amount_specific_indices!";
+        throw TxSearchException(
+                    "cant get_amount_specific_indices!");
+    }
+}
 
-    uint64_t tx_mysql_id {0};
+{
+    // add the outputs found into known_outputs_keys map.
+    // ring members can only be outputs from earlier blocks,
+    // so having all outputs from the window here before identifying
+    // inputs gives the same results as doing it tx by tx
+    std::lock_guard<std::mutex> lck (getting_known_outputs_keys);
 
-    // create pointer to mysql transaction object
-    // that we will initilize if we find something.
-    unique_ptr<mysqlpp::Transaction> mysql_transaction;
+    // copied only if we have new outputs, which is rare
+    shared_ptr<known_outputs_t> new_known_outputs;
 
-    // if we identified some outputs as ours,
-    // save them into mysql.
-    if (!outputs_identified.empty())
+    for (size_t i: txs_to_scan)
     {
-        auto tx_hash_str = pod_to_hex(tx_hash);
-        auto tx_hash_prefix_str
-            = pod_to_hex(get_transaction_prefix_hash(tx));
-        auto tx_pub_key_str
-            = pod_to_hex(identifier.get_tx_pub_key());
-        uint64_t mixin_no {0};
-        if (!is_coinbase)
-            mixin_no = xmreg::get_mixin_no(tx);
+        bool is_rct = (txs_in_blocks[i].version == 2);
 
-
-        if (!blk_timestamp_mysql_format)
+        for (auto const& out_info: outputs_identified_in_txs[i])
         {
-            blk_timestamp_mysql_format
-                    = unique_ptr<DateTime>(
-                            new DateTime(
-                            static_cast<time_t>(blk_timestamp)));
+            if (!new_known_outputs)
+                new_known_outputs = make_shared<known_outputs_t>(
+                            *known_outputs_keys);
+
+            new_known_outputs->insert({out_info.pub_key, out_info.amount});
+
+            add_known_output_index(
+                    out_info.pub_key, out_info.amount,
+                    amount_specific_indices_in_txs[i].at(out_info.idx_in_tx),
+                    is_rct);
         }
+    }
 
-        if (!mysql_transaction)
-        {
-            // start mysql transaction here
-            mysql_transaction = unique_ptr<mysqlpp::Transaction>(new mysqlpp::Transaction(*conn));
+    if (new_known_outputs)
+    {
+        std::atomic_store(&known_outputs_keys,
+                          shared_ptr<known_outputs_t const>
+                                {std::move(new_known_outputs)});
+        ++known_outputs_version;
+    }
+}
 
-            // when we rescan blockchain some txs can already
-            // be present in the mysql. So remove them, and their
-            // associated data in that case to repopulate fresh
-            // tx data
-            if (!delete_existing_tx_if_exists(tx_hash_str))
-                throw TxSearchException("Cant delete tx "
-                             + tx_hash_str);
+// blocks below indexed_height are in the ring member index,
+// so we check only those which have our outputs as ring members.
+// blocks above it, e.g., near the top of the blockchain, are
+// checked as usual.
+auto ring_member_index = current_bc_status->get_ring_member_index();
 
-        }
+// read before indexed_height, so that blocks popped after
+// it are noticed next time
+uint64_t no_of_pops = ring_member_index
+        ? ring_member_index->get_no_of_pops() : 0;
 
-        if (!current_bc_status->tx_exist(tx_hash, blockchain_tx_id))
-        {
-            OMERROR << "Tx " << tx_hash_str
-                    << " not found in blockchain!";
-            throw TxSearchException("Cant get tx from blockchain: "
-                                    + tx_hash_str);
-        }
+uint64_t indexed_height = ring_member_index
+        ? ring_member_index->get_indexed_height() : 0;
 
-        OMVLOG1 << address_prefix + ": found some outputs in block "
-                << blk_height << ", tx: " << tx_hash_str;
+if (indexed_height > h1)
+    update_spend_candidates(ring_member_index, indexed_height,
+                            no_of_pops);
 
+// SECOND, inputs. known outputs are only read now
+auto known_outputs = get_known_outputs_snapshot();
 
-        XmrTransaction tx_data;
-
-        tx_data.id               = mysqlpp::null;
-        tx_data.hash             = tx_hash_str;
-        tx_data.prefix_hash      = tx_hash_prefix_str;
-        tx_data.tx_pub_key       = tx_pub_key_str;
-        tx_data.account_id       = account_id;
-        tx_data.blockchain_tx_id = blockchain_tx_id;
-        tx_data.total_received   = total_received;
-        tx_data.total_sent       = 0; // at this stage we don't have
-                                     //  anyinfo about spendings
-
-                                     // this is current block
-                                     // + unlock time
-                                     // for regular tx,
-                                     // the unlock time is
-                                     // default of 10 blocks.
-                                     // for coinbase tx it is 60 blocks
-        tx_data.unlock_time      = tx_unlock_time;
-
-        tx_data.height           = blk_height;
-        tx_data.coinbase         = is_coinbase;
-        tx_data.is_rct           = is_rct;
-        tx_data.rct_type         = rct_type;
-        tx_data.spendable        = is_spendable;
-        tx_data.payment_id       = current_bc_status
-                                    ->get_payment_id_as_string(tx);
-        tx_data.mixin            = mixin_no;
-        tx_data.timestamp        = *blk_timestamp_mysql_format;
-
-
-        // insert tx_data into mysql's Transactions table
-        tx_mysql_id = xmr_accounts->insert(tx_data, conn);
-
-        // get amount specific (i.e., global) indices of outputs
-        if (!current_bc_status->get_amount_specific_indices(
-                tx_hash, amount_specific_indices))
-        {
-            OMERROR << address_prefix
-                       + ": cant get_amount_specific_indices!";
-            throw TxSearchException(
-                        "cant get_amount_specific_indices!");
-        }
+for_each_tx([&](size_t i)
+{
+    uint64_t blk_height = std::get<0>(txs_data[i]);
 
-        if (tx_mysql_id == 0)
-        {
-            OMERROR << address_prefix
-                       + ": tx_mysql_id is zero!"
-                    << tx_data;
-            throw TxSearchException("tx_mysql_id is zero!");
-        }
+    if (blk_height < indexed_height
+            && spend_candidate_heights.count(blk_height) == 0)
+        return;
 
-        vector<XmrOutput> outputs_found;
+    if (spend_detection_by_global_index)
+    {
+        identify_inputs_by_global_index(txs_in_blocks[i],
+                                        inputs_identified_in_txs[i]);
+        return;
+    }
 
-        // now add the found outputs into Outputs tables
-        for (auto&& out_info: outputs_identified)
-        {
-            XmrOutput out_data;
+    auto identifier = make_identifier(txs_in_blocks[i],
+                        make_unique<Input>(&address, &viewkey,
+                                           known_outputs.get(),
+                                           &mcore_addapter));
+    identifier.identify();
 
-            out_data.id           = mysqlpp::null;
-            out_data.account_id   = account_id;
-            out_data.tx_id        = tx_mysql_id;
-            out_data.out_pub_key  = pod_to_hex(out_info.pub_key);
-            out_data.tx_pub_key   = tx_pub_key_str;
-            out_data.amount       = out_info.amount;
-            out_data.out_index    = out_info.idx_in_tx;
-            out_data.rct_outpk    = pod_to_hex(out_info.rtc_outpk);
-            out_data.rct_mask     = pod_to_hex(out_info.rtc_mask);
-            out_data.rct_amount   = pod_to_hex(out_info.rtc_amount);
-            out_data.global_index = amount_specific_indices
-                    .at(out_data.out_index);
-            out_data.mixin        = tx_data.mixin;
-            out_data.timestamp    = tx_data.timestamp;
+    for (auto const& in_info: identifier.get<Input>()->get())
+        inputs_identified_in_txs[i].push_back(
+            {in_info.key_img, in_info.amount, in_info.out_pub_key});
+});
 
-            outputs_found.push_back(std::move(out_data));
+// grab a mysql connection from pool to use for queries
+auto conn = MySqlConnectionPool::get().grab_shared();
 
-            {
-                // add the outputs found into known_outputs_keys map
-                std::lock_guard<std::mutex> lck (
-                            getting_known_outputs_keys);
-                known_outputs_keys.insert(
-                    {out_info.pub_key, out_info.amount});
-            }
+// rows found in the whole window. they are handed to DbWriter at the
+// end, which writes them with one multi-row insert per table.
+// mysql ids of txs are not known before that, so until then tx_id of
+// outputs and inputs is the index of their tx in txs_found.
+auto window_write = make_shared<WindowWrite>();
 
-        } //  for (auto& out_info: outputs_identified)
+window_write->account_id = account_id;
+window_write->h1         = h1;
+window_write->h2         = h2;
 
+auto& txs_found     = window_write->txs;
+auto& outputs_found = window_write->outputs;
+auto& inputs_found  = window_write->inputs;
 
-        // insert all outputs found into mysql's outputs table
-        uint64_t no_rows_inserted
-                = xmr_accounts->insert(outputs_found, conn);
+// our outputs found so far in this window. they may be not in
+// mysql yet, so their ids are found when the window is written
+//                    out_pub_key, amount
+unordered_map<string, uint64_t> window_outputs;
 
-        if (no_rows_inserted == 0)
-        {
-            OMERROR << address_prefix 
-                    << ": insert outputs_found: no_rows_inserted is zero!"
-                    << " in tx " << tx_hash_str << " in blk " << blk_height
-                    << ' ' << outputs_found;
+// inputs_found which spend outputs from window_outputs, with public
+// keys of these outputs. their output_id is set after outputs
+// are written
+auto& inputs_of_window_outputs = window_write->inputs_of_window_outputs;
 
-            continue;
-            //throw TxSearchException("insert output_found: "
-            //                        "no_rows_inserted is zero!");
-        }
+for (size_t tx_idx: txs_to_scan)
+{
+    auto const& tx_tuple        = txs_data[tx_idx];
+    crypto::hash const& tx_hash = txs_hashes_from_blocks[tx_idx];
+    transaction const& tx       = txs_in_blocks[tx_idx];
+    uint64_t blk_height         = std::get<0>(tx_tuple);
+    uint64_t blk_timestamp      = std::get<1>(tx_tuple);
+    bool is_coinbase            = std::get<2>(tx_tuple);
+    bool is_rct                 = (tx.version == 2);
+    uint8_t rct_type            = (is_rct ? tx.rct_signatures.type : 0);
 
-    } // if (!found_mine_outputs.empty())
+    auto const& outputs_identified
+        = outputs_identified_in_txs[tx_idx];
+
+    auto const& inputs_identfied
+        = inputs_identified_in_txs[tx_idx];
 
-    // SECOND component: Checking for our key images, i.e., inputs.
+    if (outputs_identified.empty() && inputs_identfied.empty())
+        continue;
 
-    // no need mutex here, as this will be exectued only after
-    // the above. there is no threads here.
+    auto tx_hash_str = pod_to_hex(tx_hash);
 
-    auto const& inputs_identfied = identifier.get<Input>()->get();
+    DateTime blk_timestamp_mysql_format {static_cast<time_t>(blk_timestamp)};
 
+    // SECOND component first: checking for our key images, i.e.,
+    // inputs. our outputs found in this tx cant be used in its
+    // own inputs, so they are added to window_outputs later.
+
+    vector<XmrInput> tx_inputs;
+    vector<pair<size_t, string>> tx_inputs_of_window_outputs;
 
     if (!inputs_identfied.empty())
     {
         // some inputs were identified as ours in a given tx.
         // so now, go over those inputs, and check
         // get detail info for each found mixin output from database
+        // or from outputs found earlier in this window
 
-        auto tx_hash_str = pod_to_hex(tx_hash);
-        auto tx_hash_prefix_str
-            = pod_to_hex(get_transaction_prefix_hash(tx));
-        auto tx_pub_key_str
-            = pod_to_hex(identifier.get_tx_pub_key());
-        uint64_t mixin_no {0};
-        if (mixin_no == 0 && !is_coinbase)
-            mixin_no = xmreg::get_mixin_no(tx);
+        OMVLOG1 << address_prefix + ": found some possible "
+                << "inputs in block " << blk_height << ", tx: "
+                << tx_hash_str;
 
-        if (!blk_timestamp_mysql_format)
+        for (auto& in_info: inputs_identfied)
         {
-            blk_timestamp_mysql_format
-                    = unique_ptr<DateTime>(
-                    new DateTime(
-                            static_cast<time_t>(blk_timestamp)));
-        }
+            auto out_pub_key_str = pod_to_hex(in_info.out_pub_key);
 
-        if (!mysql_transaction)
-        {
-            // start mysql transaction here if not already present
-            mysql_transaction = unique_ptr<mysqlpp::Transaction>(new mysqlpp::Transaction(*conn));
+            XmrInput in_data;
+
+            in_data.id          = mysqlpp::null;
+            in_data.account_id  = account_id;
+            in_data.tx_id       = 0; // later we set it
+            in_data.key_image   = pod_to_hex(in_info.key_img);
+            in_data.timestamp   = blk_timestamp_mysql_format;
 
-            // when we rescan blockchain some txs can already
-            // be present in the mysql. So remove them, and their
-            // associated data in that case to repopulate fresh tx data
+            auto window_out = window_outputs.find(out_pub_key_str);
 
-            // this will only execture if no outputs were found
-            // above. So there is no risk of deleting same tx twice
-            if (!delete_existing_tx_if_exists(tx_hash_str))
+            if (window_out != window_outputs.end())
             {
-                throw TxSearchException(
-                        "Cant delete tx " + tx_hash_str);
+                in_data.output_id = 0; // set after outputs are written
+                in_data.amount    = window_out->second;
+
+                tx_inputs_of_window_outputs.emplace_back(
+                            tx_inputs.size(), out_pub_key_str);
+
+                tx_inputs.push_back(in_data);
+
+                continue;
             }
-        }
 
-        if (blockchain_tx_id == 0)
-        {
-            if (!current_bc_status
-                    ->tx_exist(tx_hash, blockchain_tx_id))
+            XmrOutput out;
+
+            if (xmr_accounts->output_exists(out_pub_key_str, out, conn))
             {
-                OMERROR << address_prefix  + ": tx "
-                        << tx_hash_str
-                         << "not found in blockchain !";
-                throw TxSearchException(
-                            "Cant get tx from blockchain: "
-                            + tx_hash_str);
+                // seems that this key image is ours.
+                // amount must match corresponding output's amount
+                in_data.output_id   = out.id.data;
+                in_data.amount      = out.amount;
+
+                tx_inputs.push_back(in_data);
             }
-        }
 
-        OMVLOG1 << address_prefix + ": found some possible "
-                << "inputs in block " << blk_height << ", tx: "
-                << tx_hash_str;
+        } // for (auto& in_info: inputs_identfied)
+    }
 
-        vector<XmrInput> inputs_found;
+    if (outputs_identified.empty() && tx_inputs.empty())
+        continue;
 
-        for (auto& in_info: inputs_identfied)
-        {
-            XmrOutput out;
+    // flag indicating whether the txs in the given block are
+    // spendable.
+    // this is true when block number is more than 10 blocks
+    // from current blockchain height.
+    // if tx.unlock_time is not given (its value is 0), we set it
+    // here. For coinbase its always given, so no need to check
+    // for that
 
-            if (xmr_accounts->output_exists(
-                        pod_to_hex(in_info.out_pub_key), out, conn))
-            {
+    uint64_t tx_unlock_time = tx.unlock_time;
 
-                // seems that this key image is ours.
-                // so get it information from database into XmrInput
-                // database structure that will be written later
-                // on into database.
+    if (tx_unlock_time == 0)
+        tx_unlock_time = blk_height
+            + CRYPTONOTE_DEFAULT_TX_SPENDABLE_AGE;
 
-                XmrInput in_data;
+    bool is_spendable = current_bc_status->is_tx_unlocked(
+            tx_unlock_time, blk_height);
 
-                in_data.id          = mysqlpp::null;
-                in_data.account_id  = acc->id.data;
-                in_data.tx_id       = 0; // later we set it
-                in_data.output_id   = out.id.data;
-                in_data.key_image   = pod_to_hex(in_info.key_img);
-                in_data.amount      = out.amount;
-                                        // must match corresponding
-                                        // output's amount
-                in_data.timestamp   = *blk_timestamp_mysql_format;
+    // this is id of txs in lmdb blockchain table.
+    // it will be used mostly to sort txs in the frontend.
+    uint64_t blockchain_tx_id {0};
 
-                inputs_found.push_back(in_data);
+    if (!current_bc_status->tx_exist(tx_hash, blockchain_tx_id))
+    {
+        OMERROR << "Tx " << tx_hash_str
+                << " not found in blockchain!";
+        throw TxSearchException("Cant get tx from blockchain: "
+                                + tx_hash_str);
+    }
 
-            } // if (xmr_accounts->output_exists(o
+    uint64_t mixin_no {0};
 
-        } // for (auto& in_info: inputs_identfied)
+    if (!is_coinbase)
+        mixin_no = xmreg::get_mixin_no(tx);
+
+    // calculate how much we preasumply spent. its only
+    // set for txs without our outputs, same as before
+    uint64_t total_sent {0};
+
+    if (outputs_identified.empty())
+        for (const XmrInput& in_data: tx_inputs)
+            total_sent += in_data.amount;
+
+    XmrTransaction tx_data;
+
+    tx_data.id               = mysqlpp::null;
+    tx_data.hash             = tx_hash_str;
+    tx_data.prefix_hash      = pod_to_hex(get_transaction_prefix_hash(tx));
+    tx_data.tx_pub_key       = pod_to_hex(tx_pub_keys[tx_idx]);
+    tx_data.account_id       = account_id;
+    tx_data.blockchain_tx_id = blockchain_tx_id;
+    tx_data.total_received   = calc_total_xmr(outputs_identified);
+    tx_data.total_sent       = total_sent;
+
+                                 // this is current block
+                                 // + unlock time
+                                 // for regular tx,
+                                 // the unlock time is
+                                 // default of 10 blocks.
+                                 // for coinbase tx it is 60 blocks
+    tx_data.unlock_time      = tx_unlock_time;
+
+    tx_data.height           = blk_height;
+    tx_data.coinbase         = is_coinbase;
+    tx_data.is_rct           = is_rct;
+    tx_data.rct_type         = rct_type;
+    tx_data.spendable        = is_spendable;
+    tx_data.payment_id       = current_bc_status
+                                ->get_payment_id_as_string(tx);
+    tx_data.mixin            = mixin_no;
+    tx_data.timestamp        = blk_timestamp_mysql_format;
 
+    // index of this tx in txs_found, used as tx_id for now
+    uint64_t tx_no = txs_found.size();
 
-        if (!inputs_found.empty())
+    // FIRST component: our outputs.
+
+    if (!outputs_identified.empty())
+    {
+        OMVLOG1 << address_prefix + ": found some outputs in block "
+                << blk_height << ", tx: " << tx_hash_str;
+
+        auto const& amount_specific_indices
+            = amount_specific_indices_in_txs[tx_idx];
+
+        for (auto&& out_info: outputs_identified)
         {
-            // seems we have some inputs found. time
-            // to write it to mysql. But first,
-            // check if this tx is written in mysql.
+            XmrOutput out_data;
 
-            // calculate how much we preasumply spent.
-            uint64_t total_sent {0};
+            out_data.id           = mysqlpp::null;
+            out_data.account_id   = account_id;
+            out_data.tx_id        = tx_no;
+            out_data.out_pub_key  = pod_to_hex(out_info.pub_key);
+            out_data.tx_pub_key   = tx_data.tx_pub_key;
+            out_data.amount       = out_info.amount;
+            out_data.out_index    = out_info.idx_in_tx;
+            out_data.rct_outpk    = pod_to_hex(out_info.rtc_outpk);
+            out_data.rct_mask     = pod_to_hex(out_info.rtc_mask);
+            out_data.rct_amount   = pod_to_hex(out_info.rtc_amount);
+            out_data.global_index = amount_specific_indices
+                    .at(out_data.out_index);
+            out_data.mixin        = tx_data.mixin;
+            out_data.timestamp    = tx_data.timestamp;
 
-            for (const XmrInput& in_data: inputs_found)
-                total_sent += in_data.amount;
+            window_outputs[out_data.out_pub_key] = out_data.amount;
 
-            if (tx_mysql_id == 0)
-            {
-                // this txs hasnt been seen in step first.
-                // it means that it only contains potentially our
-                // key images. It does not have our outputs.
-                // so write it to mysql as ours, with
-                // total received of 0.
-
-                XmrTransaction tx_data;
-
-                tx_data.id               = mysqlpp::null;
-                tx_data.hash             = tx_hash_str;
-                tx_data.prefix_hash      = tx_hash_prefix_str;
-                tx_data.tx_pub_key       = tx_pub_key_str;
-                tx_data.account_id       = acc->id.data;
-                tx_data.blockchain_tx_id = blockchain_tx_id;
-                tx_data.total_received   = 0; // because this is
-                                              //spending,
-                                              //total_recieved is 0
-                tx_data.total_sent       = total_sent;
-                tx_data.unlock_time      = tx_unlock_time;
-                tx_data.height           = blk_height;
-                tx_data.coinbase         = is_coinbase;
-                tx_data.is_rct           = is_rct;
-                tx_data.rct_type         = rct_type;
-                tx_data.spendable        = is_spendable;
-                tx_data.payment_id       = current_bc_status
-                                ->get_payment_id_as_string(tx);
-                tx_data.mixin            = mixin_no;
-                tx_data.timestamp    = *blk_timestamp_mysql_format;
-
-                // insert tx_data into mysql's Transactions table
-                tx_mysql_id = xmr_accounts->insert(tx_data, conn);
-
-                if (tx_mysql_id == 0)
-                {
-                    OMERROR << address_prefix
-                               + ": tx_mysql_id is zero!"
-                            << tx_data;
-
-                    //cerr << "tx_mysql_id is zero!" << endl;
-                    throw TxSearchException("tx_mysql_id is zero!");
-                    // it did not insert this tx, because maybe
-                    // it already
-                    // exisits in the MySQL. So maybe can now
-                    // check if we have it and get tx_mysql_id this
-                    // way.
-                }
-
-            } //   if (tx_mysql_id == 0)
-
-            // save all input found into database at once
-            // but first update tx_mysql_id for these inputs
-            for (XmrInput& in_data: inputs_found)
-                in_data.tx_id = tx_mysql_id; // set tx id now.
-                                            //before we made it 0
-
-            uint64_t no_rows_inserted
-                    = xmr_accounts->insert(inputs_found, conn);
-            
-            if (no_rows_inserted == 0)
-            {
-                OMERROR << address_prefix 
-                        << ": insert inputs_found: no_rows_inserted is zero!"
-                        << " in tx " << tx_hash_str << " in blk " << blk_height 
-                        << ' ' << inputs_found;
+            outputs_found.push_back(std::move(out_data));
 
-                continue;
-                //throw TxSearchException(
-                            //"insert inputs_found: no_rows_inserted is zero!");
-            }
+        } //  for (auto& out_info: outputs_identified)
+    }
 
-        } //  if (!inputs_found.empty())
+    for (auto& in_data: tx_inputs)
+        in_data.tx_id = tx_no;
 
-    } //  if (!oi_identification.identified_inputs.empty())
+    for (auto& in_out: tx_inputs_of_window_outputs)
+        inputs_of_window_outputs.emplace_back(
+                inputs_found.size() + in_out.first,
+                std::move(in_out.second));
 
-    // if we get to this point, we assume that all tx related
-    // tables are ready
-    // to be written, i.e., Transactions,
-    // Outputs and Inputs. If so, write
-    // all this into database.
+    inputs_found.insert(inputs_found.end(),
+                        std::make_move_iterator(tx_inputs.begin()),
+                        std::make_move_iterator(tx_inputs.end()));
 
-    if (mysql_transaction)
-        mysql_transaction->commit();
+    txs_found.push_back(std::move(tx_data));
 
-} // for (auto const& tx_pair: txs_map)
+} // for (size_t tx_idx: txs_to_scan)
 
 // update scanned_block_height every given interval
 // or when we reached top of the blockchain
 
-std::lock_guard<std::mutex> acc_lck(access_acc);
+uint64_t acc_changes_before_write;
+
+{
+    std::lock_guard<std::mutex> acc_lck(access_acc);
+
+    window_write->acc = *acc;
+    acc_changes_before_write = acc_changes;
+}
 
-XmrAccount updated_acc = *acc;
+window_write->updated_acc = window_write->acc;
 
-updated_acc.scanned_block_height    = h2;
-updated_acc.scanned_block_timestamp
+window_write->updated_acc.scanned_block_height    = h2;
+window_write->updated_acc.scanned_block_timestamp
         = DateTime(static_cast<time_t>(
-                       blocks.back().timestamp));
+                       window.last_block_timestamp));
 
-if (xmr_accounts->update(*acc, updated_acc, conn))
+// the rows and scanned_block_height are written together, and
+// we wait until they are committed. access_acc is not held
+// here, so that getting acc is not blocked by mysql
+current_bc_status->get_db_writer()->write(window_write);
+
+if (window_write->acc_updated)
 {
-    // iff success, set acc to updated_acc;
-    //cout << "scanned_block_height updated\n";
-    *acc = updated_acc;
+    std::lock_guard<std::mutex> acc_lck(access_acc);
+
+    // iff success, set acc to updated_acc, unless
+    // it was replaced using update_acc in the meantime
+    if (acc_changes == acc_changes_before_write)
+        *acc = window_write->updated_acc;
 }
 
-//current_timestamp = loop_timestamp;
+// txs of this window are already commited, so requests
+// which get the new version will also get them
+bump_state_version();
+
 // update this only when this variable is false
 // otherwise a new search block value can
 // be overwritten to h2, instead of the new value
@@ -630,8 +549,6 @@ if (!searched_block_got_updated)
 
 searched_block_got_updated = false;
 
-} // while(continue_search)
-
 }
 catch(std::exception const& e)
 {
@@ -647,12 +564,6 @@ catch(...)
     set_exception_ptr();
 }
 
-searching_is_ongoing = false;
-
-// it will stop anyway, but just call it so we get info message pritened out
-stop();
-
-
 }
 
 void
@@ -702,68 +613,316 @@ TxSearch::ping()
 bool
 TxSearch::still_searching() const
 {
-    return searching_is_ongoing;
+    return continue_search;
+}
+
+void
+TxSearch::stop_if_not_pinged()
+{
+    // if search has lived longer than thread_search_life
+    // without last_ping_timestamp being updated,
+    // stop the search
+    if (get_current_timestamp() - last_ping_timestamp
+            > thread_search_life)
+    {
+        OMINFO << address_prefix
+                  + ": search thread stopped.";
+        stop();
+    }
 }
 
 void
 TxSearch::populate_known_outputs()
 {
-    vector<XmrOutput> outs;
+    // ringct outputs are marked by is_rct of their txs,
+    // as their global indices are for amount 0
+    vector<XmrKnownOutput> outs;
 
-    if (xmr_accounts->select(acc->id.data, outs))
+    if (xmr_accounts->select_known_outputs(acc->id.data, outs))
     {
-        for (const XmrOutput& out: outs)
+        auto new_known_outputs = make_shared<known_outputs_t>();
+
+        for (const XmrKnownOutput& out: outs)
         {
             public_key out_pub_key;
 
-            hex_to_pod(out.out_pub_key, out_pub_key);
+            if (out.out_pub_key.size() != sizeof(out_pub_key))
+                continue;
+
+            std::memcpy(&out_pub_key, out.out_pub_key.data(),
+                        sizeof(out_pub_key));
 
-            known_outputs_keys[out_pub_key] = out.amount;
+            (*new_known_outputs)[out_pub_key] = out.amount;
+
+            add_known_output_index(out_pub_key, out.amount,
+                                   out.global_index, out.is_rct);
+        }
+
+        std::lock_guard<std::mutex> lck (getting_known_outputs_keys);
+
+        std::atomic_store(&known_outputs_keys,
+                          shared_ptr<known_outputs_t const>
+                                {std::move(new_known_outputs)});
+        ++known_outputs_version;
+    }
+}
+
+void
+TxSearch::update_spend_candidates(RingMemberIndex* ring_member_index,
+                                  uint64_t indexed_height,
+                                  uint64_t no_of_pops)
+{
+    uint64_t min_height {0};
+
+    // after a reorg, blocks above the popped height were indexed
+    // again, possibly below spend_candidates_indexed_height. they
+    // can have different txs, so everything is looked up again.
+    if (spend_candidates_no_of_outputs == known_outputs_indices.size()
+            && spend_candidates_no_of_pops == no_of_pops)
+    {
+        if (spend_candidates_indexed_height == indexed_height)
+            return;
+
+        // no new outputs, so only blocks added to
+        // the index since the last time need checking
+        min_height = spend_candidates_indexed_height;
+    }
+    else
+    {
+        spend_candidate_heights.clear();
+    }
+
+    for (auto const& kv: known_outputs_indices)
+    {
+        auto heights = ring_member_index->find(kv.first.first,
+                                               kv.first.second,
+                                               min_height);
+
+        spend_candidate_heights.insert(heights.begin(), heights.end());
+    }
+
+    spend_candidates_no_of_outputs = known_outputs_indices.size();
+    spend_candidates_indexed_height = indexed_height;
+    spend_candidates_no_of_pops = no_of_pops;
+}
+
+void
+TxSearch::add_known_output_index(public_key const& out_pub_key,
+                                 uint64_t amount,
+                                 uint64_t global_index,
+                                 bool is_rct)
+{
+    // global indices of ringct outputs are counted among
+    // amount 0 outputs, whatever their real amount is
+    known_outputs_indices[{is_rct ? 0 : amount, global_index}]
+            = {out_pub_key, amount};
+}
+
+void
+TxSearch::identify_inputs_by_global_index(
+        transaction const& tx,
+        vector<IdentifiedInput>& inputs_found) const
+{
+    // same as Input identifier, but instead of getting
+    // public keys of all ring members from lmdb, we just
+    // check if their global indices are of our outputs.
+    for (auto const& in: tx.vin)
+    {
+        if (in.type() != typeid(txin_to_key))
+            continue;
+
+        auto const& in_key = boost::get<txin_to_key>(in);
+
+        // key_offsets are relative to each other
+        vector<uint64_t> absolute_offsets
+                = relative_output_offsets_to_absolute(
+                        in_key.key_offsets);
+
+        for (uint64_t global_index: absolute_offsets)
+        {
+            auto it = known_outputs_indices.find(
+                        {in_key.amount, global_index});
+
+            if (it == known_outputs_indices.end())
+                continue;
+
+            inputs_found.push_back({in_key.k_image,
+                                    it->second.second,
+                                    it->second.first});
         }
     }
 }
 
 TxSearch::known_outputs_t
 TxSearch::get_known_outputs_keys()
+{
+    return *get_known_outputs_snapshot();
+};
+
+shared_ptr<TxSearch::known_outputs_t const>
+TxSearch::get_known_outputs_snapshot() const
+{
+    return std::atomic_load(&known_outputs_keys);
+}
+
+shared_ptr<TxSearch::known_outputs_t const>
+TxSearch::get_known_outputs_snapshot(uint64_t& version)
 {
     std::lock_guard<std::mutex> lck (getting_known_outputs_keys);
+
+    version = known_outputs_version;
+
     return known_outputs_keys;
-};
+}
 
 void
 TxSearch::find_txs_in_mempool(
-        TxSearch::pool_txs_t mempool_txs,
+        TxSearch::pool_txs_t const& mempool_txs,
         json* j_transactions)
-{   
+{
+    // usually all txs are already identified, as its done
+    // when they come to the mempool. but this account could
+    // have been just started, or found new outputs
+    update_mempool_txs(mempool_txs);
 
-*j_transactions = json::array();
+    *j_transactions = json::array();
 
-uint64_t current_height = current_bc_status
-        ->get_current_blockchain_height();
+    uint64_t current_height = current_bc_status
+            ->get_current_blockchain_height();
 
-auto current_bc_status_ptr = current_bc_status.get();
+    std::lock_guard<std::mutex> lck (getting_mempool_txs_json);
+
+    for (auto const& mtx: mempool_txs)
+    {
+        auto it = mempool_txs_json.find(mtx->tx_hash);
 
-known_outputs_t known_outputs_keys_copy = get_known_outputs_keys();
+        if (it == mempool_txs_json.end() || it->second.is_null())
+            continue;
 
-// since find_txs_in_mempool can be called outside of this thread,
-// we need to use local connection. we cant use connection that the
-// main search method is using, as we can end up wtih mysql errors
-// mysql will blow up when two queries are done at the same
-// time in a single connection.
-// so we create local connection here, only to be used in this method.
+        json j_tx = it->second;
 
-auto local_xmr_accounts = make_shared<MySqlAccounts>(current_bc_status);
+        // put current blockchain height, just to indicate to
+        // frontend that this tx is younger than 10 blocks so
+        // that it shows unconfirmed message.
+        j_tx["height"] = current_height;
 
-MicroCoreAdapter mcore_addapter {current_bc_status_ptr};
+        j_transactions->push_back(std::move(j_tx));
+    }
+}
 
-for (auto const& mtx: mempool_txs)
+void
+TxSearch::update_mempool_txs(pool_txs_t const& mempool_txs)
 {
+    std::lock_guard<std::mutex> update_lck (updating_mempool_txs);
+
+    uint64_t known_outputs_version;
+
+    auto known_outputs = get_known_outputs_snapshot(known_outputs_version);
+
+    // whether txs found in the mempool for this account changed
+    bool found_txs_changed {false};
 
-uint64_t recieve_time = mtx.first;
+    std::unordered_set<crypto::hash> in_pool;
 
-const transaction& tx = mtx.second;
+    for (auto const& mtx: mempool_txs)
+        in_pool.insert(mtx->tx_hash);
 
-const crypto::hash tx_hash = get_transaction_hash(tx);
+    vector<shared_ptr<MempoolTx const>> new_txs;
+
+    {
+        std::lock_guard<std::mutex> lck (getting_mempool_txs_json);
+
+        // new outputs can make txs which we already checked
+        // spend our outputs
+        if (known_outputs_version != mempool_txs_known_outputs_version)
+        {
+            found_txs_changed = !mempool_txs_json.empty();
+
+            mempool_txs_json.clear();
+            mempool_txs_known_outputs_version = known_outputs_version;
+        }
+
+        // forget txs which left the mempool
+        for (auto it = mempool_txs_json.begin();
+             it != mempool_txs_json.end();)
+        {
+            if (in_pool.count(it->first) == 0)
+            {
+                found_txs_changed |= !it->second.is_null();
+                it = mempool_txs_json.erase(it);
+            }
+            else
+            {
+                ++it;
+            }
+        }
+
+        for (auto const& mtx: mempool_txs)
+            if (mempool_txs_json.count(mtx->tx_hash) == 0)
+                new_txs.push_back(mtx);
+    }
+
+    if (new_txs.empty())
+    {
+        if (found_txs_changed)
+            bump_state_version();
+
+        return;
+    }
+
+    // since this can be called outside of the scanning thread,
+    // we need to use local connection. we cant use connection that the
+    // scan_window is using, as we can end up wtih mysql errors
+    // mysql will blow up when two queries are done at the same
+    // time in a single connection.
+    // so we create local connection here, only when its needed.
+    shared_ptr<MySqlAccounts> local_xmr_accounts;
+
+    // identified without holding getting_mempool_txs_json, as
+    // it can take a while when our outputs are spent
+    vector<json> new_txs_json;
+
+    new_txs_json.reserve(new_txs.size());
+
+    for (auto const& mtx: new_txs)
+    {
+        new_txs_json.push_back(identify_mempool_tx(*mtx, *known_outputs,
+                                                   local_xmr_accounts));
+
+        found_txs_changed |= !new_txs_json.back().is_null();
+    }
+
+    {
+        std::lock_guard<std::mutex> lck (getting_mempool_txs_json);
+
+        // only this method modifies mempool_txs_json, and its
+        // not executed concurrently, so the map is as we left it
+        for (size_t i = 0; i < new_txs.size(); ++i)
+            mempool_txs_json[new_txs[i]->tx_hash]
+                    = std::move(new_txs_json[i]);
+    }
+
+    if (found_txs_changed)
+        bump_state_version();
+}
+
+json
+TxSearch::identify_mempool_tx(
+        MempoolTx const& mtx,
+        known_outputs_t const& known_outputs,
+        shared_ptr<MySqlAccounts>& local_xmr_accounts)
+{
+json j_found_tx;
+
+auto current_bc_status_ptr = current_bc_status.get();
+
+MicroCoreAdapter mcore_addapter {current_bc_status_ptr};
+
+uint64_t recieve_time = mtx.receive_time;
+
+const transaction& tx = mtx.tx;
+
+const crypto::hash& tx_hash = mtx.tx_hash;
 bool is_rct                 = (tx.version == 2);
 uint8_t rct_type            = (is_rct ? tx.rct_signatures.type : 0);
 
@@ -773,7 +932,7 @@ uint8_t rct_type            = (is_rct ? tx.rct_signatures.type : 0);
 auto identifier = make_identifier(tx, 
                     make_unique<Output>(&address, &viewkey),
                     make_unique<Input>(&address, &viewkey, 
-                                       &known_outputs_keys, 
+                                       &known_outputs, 
                                        &mcore_addapter));
 
 identifier.identify();
@@ -817,10 +976,8 @@ if (!outputs_identified.empty())
     j_tx["total_sent"]     = "0"; // to be set later when looking for key images
     j_tx["unlock_time"]    = "0"; // for mempool we set it to zero
                                 // since we dont have block_height to work with
-    j_tx["height"]         = current_height; // put current blockchain height,
-                                // just to indicate to frontend that this
-                                // tx is younger than 10 blocks so that
-                                // it shows unconfirmed message.
+    j_tx["height"]         = 0; // set to current blockchain height
+                                // in find_txs_in_mempool
     j_tx["payment_id"]     = current_bc_status->get_payment_id_as_string(tx);
     j_tx["coinbase"]       = false; // pool tx are not coinbase, so always false
     j_tx["is_rct"]         = is_rct;
@@ -828,7 +985,7 @@ if (!outputs_identified.empty())
     j_tx["mixin"]          = mixin_no;
     j_tx["mempool"]        = true;
 
-    j_transactions->push_back(j_tx);
+    j_found_tx = j_tx;
 }
 
 
@@ -867,6 +1024,10 @@ if (!inputs_identfied.empty())
         // tx public key and its index in that tx
         XmrOutput out;
 
+        if (!local_xmr_accounts)
+            local_xmr_accounts
+                    = make_shared<MySqlAccounts>(current_bc_status);
+
         if (local_xmr_accounts->output_exists(
                     pod_to_hex(in_info.out_pub_key), out))
         {
@@ -895,7 +1056,7 @@ if (!inputs_identfied.empty())
             // exisiting j_tx. we add spending info
             // to j_tx created before.
 
-            json& j_tx = j_transactions->back();
+            json& j_tx = j_found_tx;
 
             j_tx["total_sent"]    = std::to_string(total_sent);
             j_tx["spent_outputs"] = spend_keys;
@@ -921,10 +1082,8 @@ if (!inputs_identfied.empty())
             j_tx["total_sent"]     = std::to_string(total_sent); // to be set later when looking for key images
             j_tx["unlock_time"]    = 0;          // for mempool we set it to zero
                                                  // since we dont have block_height to work with
-            j_tx["height"]         = current_height; // put current blockchain height,
-                                                // just to indicate to frontend that this
-                                                // tx is younger than 10 blocks so that
-                                                // it shows unconfirmed message.
+            j_tx["height"]         = 0; // set to current blockchain height
+                                        // in find_txs_in_mempool
             j_tx["payment_id"]     = current_bc_status
                     ->get_payment_id_as_string(tx);
             j_tx["coinbase"]       = false;     // mempool tx are not coinbase, so always false
@@ -934,7 +1093,7 @@ if (!inputs_identfied.empty())
             j_tx["mempool"]        = true;
             j_tx["spent_outputs"]  = spend_keys;
 
-            j_transactions->push_back(j_tx);
+            j_found_tx = j_tx;
 
         } // else of if (!identified_outputs.empty())
 
@@ -942,7 +1101,7 @@ if (!inputs_identfied.empty())
 
 } // if (!identified_inputs.empty())
 
-} // for (const transaction& tx: txs_to_check)
+return j_found_tx;
 }
 
 
@@ -968,40 +1127,20 @@ TxSearch::set_search_thread_life(seconds life_seconds)
     thread_search_life = life_seconds;
 }
 
-bool
-TxSearch::delete_existing_tx_if_exists(string const& tx_hash, shared_ptr<mysqlpp::Connection> conn)
-{
-    XmrTransaction tx_data_existing;
-
-    if (xmr_accounts->tx_exists(acc->id.data, tx_hash, tx_data_existing, conn))
-    {
-        OMVLOG1 << '\n' << address_prefix
-                  + ": tx " << tx_hash
-                << " already present in db, so remove it";
-
-        // if tx is already present for that user,
-        // we remove it, as we get it data from scrach
-
-        if (xmr_accounts->delete_tx(tx_data_existing.id.data, conn) == 0)
-        {
-            OMERROR << address_prefix  + ": cant remove tx "
-                    << tx_hash;
-            return false;
-        }
-    }
-
-    return true;
-}
-
 void
 TxSearch::update_acc(XmrAccount const& _acc)
 {
     std::lock_guard<std::mutex> acc_lck(access_acc);
     *acc = _acc;
+    ++acc_changes;
+
+    bump_state_version();
 }
 
 
 // default value of static veriables
 seconds TxSearch::thread_search_life {600};
 
+std::atomic<uint64_t> TxSearch::state_versions {0};
+
 }
@@ -1,12 +1,16 @@
 #pragma once
 
 #include "db/MySqlAccounts.h"
+#include "ScanWorkerPool.h"
+#include "RingMemberIndex.h"
 
 #include <memory>
 #include <mutex>
 #include <atomic>
+#include <set>
 #include <algorithm>
 #include <unordered_map>
+#include <unordered_set>
 
 namespace xmreg
 {
@@ -25,14 +29,72 @@ public:
     using std::runtime_error::runtime_error;
 };
 
+// blocks and their txs that are analyzed in one go.
+// a window is read from the blockchain only once and then
+// shared by all TxSearch objects whose searched_blk_no
+// falls within [h1, h2]
+struct ScanWindow
+{
+    uint64_t h1 {0};
+    uint64_t h2 {0};
+
+    // timestamp of block h2
+    uint64_t last_block_timestamp {0};
+
+    vector<crypto::hash> txs_hashes;
+    vector<transaction> txs;
+
+    //                 height , timestamp, is_coinbase
+    vector<std::tuple<uint64_t, uint64_t, bool>> txs_data;
+};
+
+// tx in our mirror of the mempool, together with its hash
+// so that it does not need to be calculated again.
+// not modified once created
+struct MempoolTx
+{
+    uint64_t receive_time;
+    crypto::hash tx_hash;
+    transaction tx;
+    vector<key_image> key_images;
+};
+
+// our output used as a ring member in an input. same as
+// info of Input identifier, so both ways of finding
+// inputs can be used interchangeably
+struct IdentifiedInput
+{
+    key_image key_img;
+    uint64_t amount;
+    public_key out_pub_key;
+};
+
 class TxSearch
 {
 
 public:
     //                                         out_pk   , amount
     using known_outputs_t = std::unordered_map<public_key, uint64_t>;
+
+    //                            amount  , global_index
+    using global_index_t = std::pair<uint64_t, uint64_t>;
+
+    struct global_index_hash
+    {
+        size_t
+        operator()(global_index_t const& idx) const
+        {
+            return std::hash<uint64_t>()(idx.first)
+                    ^ (std::hash<uint64_t>()(idx.second) << 1);
+        }
+    };
+
+    //                                                 out_pk  , amount
+    using known_outputs_indices_t = std::unordered_map<global_index_t,
+                                        std::pair<public_key, uint64_t>,
+                                        global_index_hash>;
     using addr_view_t = std::pair<address_parse_info, secret_key>;
-    using pool_txs_t = std::vector<pair<uint64_t, transaction>>;
+    using pool_txs_t = std::vector<shared_ptr<MempoolTx const>>;
 
 private:
 
@@ -44,13 +106,9 @@ private:
     // using the service.
     static seconds thread_search_life;
 
-    // indicate that a thread loop should keep running
+    // indicate that the account should be still scanned
     std::atomic_bool continue_search {true};
 
-    // this acctually indicates whether thread loop finished
-    // its execution
-    std::atomic_bool searching_is_ongoing {false};
-
     // marked true when we set new searched block value
     // from other thread. for example, when we import account
     // we set it to 0
@@ -71,13 +129,68 @@ private:
     // represents a row in mysql's Accounts table
     shared_ptr<XmrAccount> acc;
 
+    // no of times acc was replaced by update_acc.
+    // guarded by access_acc
+    uint64_t acc_changes {0};
+
     // stores known output public keys.
     // used as a cash to fast look up of
     // our public keys in key images. Saves a lot of
     // mysql queries to Outputs table.
     //
-
-    known_outputs_t known_outputs_keys;
+    // the map itself is never modified. new outputs are added
+    // to its copy, which replaces it using std::atomic_store, so
+    // readers (e.g., mempool identification) dont need to copy it
+    // or wait for scan_window. writers hold getting_known_outputs_keys.
+    shared_ptr<known_outputs_t const> known_outputs_keys
+        {std::make_shared<known_outputs_t const>()};
+
+    // increased whenever known_outputs_keys is replaced.
+    // guarded by getting_known_outputs_keys
+    uint64_t known_outputs_version {0};
+
+    // same outputs as above, but keyed by their amount
+    // and global index. with this, we can find inputs which use
+    // our outputs as ring members without going to lmdb for public
+    // keys of every ring member. amount is 0 for ringct outputs.
+    known_outputs_indices_t known_outputs_indices;
+
+    // heights of blocks with txs which use our outputs as
+    // ring members, found in ring member index. only blocks
+    // in these heights need to be checked for our inputs.
+    std::set<uint64_t> spend_candidate_heights;
+
+    // for what known_outputs_indices, index height and number
+    // of reorgs of the index spend_candidate_heights were found
+    size_t spend_candidates_no_of_outputs {0};
+    uint64_t spend_candidates_indexed_height {0};
+    uint64_t spend_candidates_no_of_pops {0};
+
+    // j_txs of mempool txs, by tx hash. txs without our outputs
+    // or inputs are kept as null, so that they are not
+    // identified again. only txs still in the mempool are kept
+    unordered_map<crypto::hash, json> mempool_txs_json;
+
+    // known_outputs_version for which mempool_txs_json were
+    // found. inputs are identified using known outputs, so
+    // mempool txs are identified again if they changed
+    uint64_t mempool_txs_known_outputs_version {0};
+
+    // held only while mempool_txs_json is read or modified,
+    // not while mempool txs are identified
+    mutex getting_mempool_txs_json;
+
+    // only one update_mempool_txs at a time
+    mutex updating_mempool_txs;
+
+    // changes whenever anything returned by get_address_txs
+    // or get_address_info for this account can change, i.e., new
+    // rows in mysql, new scanned_block_height or different
+    // mempool txs. its taken from state_versions, so values are
+    // never repeated, even by a new TxSearch of the same account
+    atomic<uint64_t> state_version {0};
+
+    static std::atomic<uint64_t> state_versions;
 
     // this manages all mysql queries
     // its better to when each thread has its own mysql connection object.
@@ -101,12 +214,22 @@ public:
     TxSearch(XmrAccount const& _acc,
              std::shared_ptr<CurrentBlockchainStatus> _current_bc_status);
 
+    // identify our outputs and inputs in the given window,
+    // starting from searched_blk_no, and save them into mysql.
+    // executed by BlockScanner, not by a thread of its own.
+    // if workers are given, txs are identified in parallel.
     virtual void
-    operator()();
+    scan_window(ScanWindow const& window,
+                ScanWorkerPool* workers = nullptr);
 
     virtual void
     stop();
 
+    // stops the search if there were no pings from the
+    // frontend for longer than thread_search_life
+    virtual void
+    stop_if_not_pinged();
+
     virtual void
     set_searched_blk_no(uint64_t new_value);
 
@@ -125,12 +248,56 @@ public:
     virtual void
     populate_known_outputs();
 
+    // copy of known outputs. get_known_outputs_snapshot
+    // should be used when only reading them
     virtual known_outputs_t
     get_known_outputs_keys();
 
+    virtual shared_ptr<known_outputs_t const>
+    get_known_outputs_snapshot() const;
+
+    // also returns known_outputs_version of the snapshot
+    virtual shared_ptr<known_outputs_t const>
+    get_known_outputs_snapshot(uint64_t& version);
+
+    // updates spend_candidate_heights using ring member index.
+    // only new part of the index is checked, unless we
+    // have new outputs or blocks were popped from the index.
+    virtual void
+    update_spend_candidates(RingMemberIndex* ring_member_index,
+                            uint64_t indexed_height,
+                            uint64_t no_of_pops);
+
+    // adds our output to known_outputs_indices. outputs of
+    // ringct txs, coinbase ones included, are under amount 0
+    virtual void
+    add_known_output_index(public_key const& out_pub_key,
+                           uint64_t amount,
+                           uint64_t global_index,
+                           bool is_rct);
+
+    // finds inputs which have our outputs as ring members
+    // using known_outputs_indices. no lmdb access.
+    virtual void
+    identify_inputs_by_global_index(
+            transaction const& tx,
+            vector<IdentifiedInput>& inputs_found) const;
+
     virtual void
     update_acc(XmrAccount const& _acc);
 
+    virtual uint64_t
+    get_state_version() const
+    {
+        return state_version;
+    }
+
+    virtual void
+    bump_state_version()
+    {
+        state_version = ++state_versions;
+    }
+
     virtual void
     set_exception_ptr()
     {
@@ -165,15 +332,25 @@ public:
      * to database later on by TxSearch thread when they will be added
      * to the blockchain.
      *
-     * we pass mempool_txs by copy because we want copy of mempool txs.
-     * to avoid worrying about synchronizing threads
+     * mempool_txs are shared pointers to txs which are not modified,
+     * usually from a snapshot of the mempool. Each tx is identified
+     * only once, in update_mempool_txs, and here only the j_txs
+     * found are merged.
      *
      * @return json
      */
     virtual void
-    find_txs_in_mempool(pool_txs_t mempool_txs,
+    find_txs_in_mempool(pool_txs_t const& mempool_txs,
                         json* j_transactions);
 
+    // identifies mempool txs which were not identified before
+    // and forgets the ones which left the mempool. its called
+    // whenever new txs come to the mempool, for all accounts.
+    // find_txs_in_mempool is not blocked while new txs are
+    // identified, they are added when all of them are done
+    virtual void
+    update_mempool_txs(pool_txs_t const& mempool_txs);
+
     virtual addr_view_t
     get_xmr_address_viewkey() const;
     
@@ -183,8 +360,13 @@ public:
     static void
     set_search_thread_life(seconds life_seconds);
 
-    virtual bool
-    delete_existing_tx_if_exists(string const& tx_hash, shared_ptr<mysqlpp::Connection> conn = nullptr);
+    // j_tx of our outputs and inputs in the given mempool tx,
+    // or null if there are none. local_xmr_accounts is created
+    // when mysql is needed for the first time
+    virtual json
+    identify_mempool_tx(MempoolTx const& mtx,
+                        known_outputs_t const& known_outputs,
+                        shared_ptr<MySqlAccounts>& local_xmr_accounts);
 
     virtual ~TxSearch();
 
@@ -65,6 +65,23 @@ TxUnlockChecker::is_unlocked(
      return true;
 }
 
+UnlockLimits
+TxUnlockChecker::get_unlock_limits(
+        network_type net_type,
+        uint64_t current_blockchain_height) const
+{
+    uint64_t current_time = get_current_time();
+
+    uint64_t v2height = get_v2height(net_type);
+
+    return {CRYPTONOTE_MAX_BLOCK_NUMBER,
+            current_blockchain_height
+                + CRYPTONOTE_LOCKED_TX_ALLOWED_DELTA_BLOCKS,
+            v2height,
+            current_time + get_leeway(0, net_type),
+            current_time + get_leeway(v2height, net_type)};
+}
+
 
 
 }
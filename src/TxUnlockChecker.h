@@ -11,6 +11,24 @@ using namespace crypto;
 using namespace std;
 
 
+// largest unlock_time values for which txs are unlocked,
+// as checked by TxUnlockChecker::is_unlocked. used to filter
+// unlocked txs in mysql, rather than one by one.
+struct UnlockLimits
+{
+    // unlock_time below it is a block height,
+    // otherwise its a timestamp
+    uint64_t max_block_number;
+
+    uint64_t max_unlock_height;
+
+    // leeway for timestamps depends on whether tx's block
+    // is below v2height or not
+    uint64_t v2height;
+    uint64_t max_unlock_time_v1;
+    uint64_t max_unlock_time_v2;
+};
+
 // class based on
 // bool wallet2::is_tx_spendtime_unlocked(uint64_t unlock_time, uint64_t block_height) const
 // and
@@ -38,6 +56,10 @@ public:
                 uint64_t tx_unlock_time,
                 uint64_t tx_block_height) const;
 
+    virtual UnlockLimits
+    get_unlock_limits(network_type net_type,
+                      uint64_t current_blockchain_height) const;
+
     virtual ~TxUnlockChecker() = default;
 
 };
@@ -13,6 +13,158 @@
 namespace xmreg
 {
 
+namespace
+{
+
+// with binary keys, Transactions, Outputs and Inputs are views
+// converting keys to hex, and mysql++ cant insert into them. so rows
+// of these tables are inserted using BIN_INTO_CLAUSE followed by
+// values of all the rows, with hex keys converted back to binary by
+// UNHEX. this way each table gets a single statement, without parsing
+// a template query for every row. for other tables false is returned.
+// with upsert, existing rows are updated using UPSERT_CLAUSE
+void
+write_bin_values(Query& query, XmrTransaction const& tx)
+{
+    query << "(UNHEX(" << mysqlpp::quote << tx.hash << "), "
+          << "UNHEX(" << mysqlpp::quote << tx.prefix_hash << "), "
+          << "UNHEX(" << mysqlpp::quote << tx.tx_pub_key << "), "
+          << mysqlpp::quote << tx.account_id << ", "
+          << mysqlpp::quote << tx.blockchain_tx_id << ", "
+          << mysqlpp::quote << tx.total_received << ", "
+          << mysqlpp::quote << tx.total_sent << ", "
+          << mysqlpp::quote << tx.unlock_time << ", "
+          << mysqlpp::quote << tx.height << ", "
+          << mysqlpp::quote << tx.coinbase << ", "
+          << mysqlpp::quote << tx.is_rct << ", "
+          << mysqlpp::quote << tx.rct_type << ", "
+          << mysqlpp::quote << tx.spendable << ", "
+          << mysqlpp::quote << tx.payment_id << ", "
+          << mysqlpp::quote << tx.mixin << ", "
+          << mysqlpp::quote << tx.timestamp << ")";
+}
+
+void
+write_bin_values(Query& query, XmrOutput const& out)
+{
+    query << "(" << mysqlpp::quote << out.account_id << ", "
+          << mysqlpp::quote << out.tx_id << ", "
+          << "UNHEX(" << mysqlpp::quote << out.out_pub_key << "), "
+          << "UNHEX(" << mysqlpp::quote << out.rct_outpk << "), "
+          << "UNHEX(" << mysqlpp::quote << out.rct_mask << "), "
+          << "UNHEX(" << mysqlpp::quote << out.rct_amount << "), "
+          << "UNHEX(" << mysqlpp::quote << out.tx_pub_key << "), "
+          << mysqlpp::quote << out.amount << ", "
+          << mysqlpp::quote << out.global_index << ", "
+          << mysqlpp::quote << out.out_index << ", "
+          << mysqlpp::quote << out.mixin << ", "
+          << mysqlpp::quote << out.timestamp << ")";
+}
+
+void
+write_bin_values(Query& query, XmrInput const& in)
+{
+    query << "(" << mysqlpp::quote << in.account_id << ", "
+          << mysqlpp::quote << in.tx_id << ", "
+          << mysqlpp::quote << in.output_id << ", "
+          << "UNHEX(" << mysqlpp::quote << in.key_image << "), "
+          << mysqlpp::quote << in.amount << ", "
+          << mysqlpp::quote << in.timestamp << ")";
+}
+
+// counts update or delete of rows of the account, see
+// XmrAccount::SELECT_CHANGES_STMT. must be done after the
+// change, so that readers of the counter cant miss it
+bool
+bump_account_changes(uint64_t account_id,
+                     shared_ptr<mysqlpp::Connection> conn)
+{
+    Query query = conn->query(XmrAccount::BUMP_CHANGES_STMT);
+    query.parse();
+
+    SimpleResult sr = query.execute(account_id);
+
+    return static_cast<bool>(sr);
+}
+
+template <typename T>
+bool
+insert_binary(Query&, T const&, SimpleResult&, bool upsert = false)
+{
+    return false;
+}
+
+template <typename T>
+bool
+insert_binary_rows(Query& query, vector<T> const& rows, SimpleResult& sr,
+                   bool upsert)
+{
+    // without upsert, duplicates are skipped as by INSERT_STMT
+    query << (upsert ? "INSERT" : "INSERT IGNORE") << T::BIN_INTO_CLAUSE;
+
+    for (size_t i = 0; i < rows.size(); ++i)
+    {
+        if (i > 0)
+            query << ", ";
+
+        write_bin_values(query, rows[i]);
+    }
+
+    if (upsert)
+        query << T::UPSERT_CLAUSE;
+
+    sr = query.execute();
+
+    return true;
+}
+
+bool
+insert_binary(Query& query, vector<XmrTransaction> const& rows,
+              SimpleResult& sr, bool upsert = false)
+{
+    return insert_binary_rows(query, rows, sr, upsert);
+}
+
+bool
+insert_binary(Query& query, vector<XmrOutput> const& rows,
+              SimpleResult& sr, bool upsert = false)
+{
+    return insert_binary_rows(query, rows, sr, upsert);
+}
+
+bool
+insert_binary(Query& query, vector<XmrInput> const& rows,
+              SimpleResult& sr, bool upsert = false)
+{
+    return insert_binary_rows(query, rows, sr, upsert);
+}
+
+bool
+insert_binary(Query& query, XmrTransaction const& tx, SimpleResult& sr,
+              bool upsert = false)
+{
+    return insert_binary_rows(query, vector<XmrTransaction> {tx},
+                              sr, upsert);
+}
+
+bool
+insert_binary(Query& query, XmrOutput const& out, SimpleResult& sr,
+              bool upsert = false)
+{
+    return insert_binary_rows(query, vector<XmrOutput> {out},
+                              sr, upsert);
+}
+
+bool
+insert_binary(Query& query, XmrInput const& in, SimpleResult& sr,
+              bool upsert = false)
+{
+    return insert_binary_rows(query, vector<XmrInput> {in},
+                              sr, upsert);
+}
+
+}
+
 bool
 MysqlInputs::select_for_out(const uint64_t& output_id,
                             vector<XmrInput>& ins, shared_ptr<mysqlpp::Connection> conn)
@@ -44,7 +196,9 @@ MysqlOutpus::exist(const string& output_public_key_str, XmrOutput& out, shared_p
     {
         // mysqlpp::ScopedConnection cp(MySqlConnectionPool::get(), true);
         if (!conn) conn = MySqlConnectionPool::get().grab_shared();
-        Query query = conn->query(XmrOutput::EXIST_STMT);
+        Query query = conn->query(MySqlConnectionPool::binary_keys
+                                  ? XmrOutput::EXIST_BIN_STMT
+                                  : XmrOutput::EXIST_STMT);
         query.parse();
 
         vector<XmrOutput> outs;
@@ -73,15 +227,27 @@ MysqlTransactions::mark_spendable(const uint64_t& tx_id_no, bool spendable, shar
     {
         // mysqlpp::ScopedConnection cp(MySqlConnectionPool::get(), true);
         if (!conn) conn = MySqlConnectionPool::get().grab_shared();
-        Query query = conn->query(
-                    spendable ?
-                      XmrTransaction::MARK_AS_SPENDABLE_STMT
-                                : XmrTransaction::MARK_AS_NONSPENDABLE_STMT);
+        Query query = conn->query(spendable
+                                  ? XmrTransaction::MARK_AS_SPENDABLE_STMT
+                                  : XmrTransaction::MARK_AS_NONSPENDABLE_STMT);
         query.parse();
 
 
         SimpleResult sr = query.execute(tx_id_no);
 
+        if (sr.rows() > 0)
+        {
+            vector<XmrTransaction> txs;
+
+            Query select_query = conn->query(XmrTransaction::SELECT_STMT2);
+            select_query.parse();
+
+            select_query.storein(txs, tx_id_no);
+
+            if (!txs.empty())
+                bump_account_changes(txs.front().account_id, conn);
+        }
+
         return sr.rows();
     }
     catch (std::exception const& e)
@@ -100,11 +266,27 @@ MysqlTransactions::delete_tx(const uint64_t& tx_id_no, shared_ptr<mysqlpp::Conne
     {
         // mysqlpp::ScopedConnection cp(MySqlConnectionPool::get(), true);
         if (!conn) conn = MySqlConnectionPool::get().grab_shared();
+
+        // account of the tx is needed to count the delete,
+        // which can be done only when the tx is already gone
+        vector<XmrTransaction> txs;
+
+        Query select_query = conn->query(XmrTransaction::SELECT_STMT2);
+        select_query.parse();
+
+        select_query.storein(txs, tx_id_no);
+
+        if (txs.empty())
+            return 0;
+
         Query query = conn->query(XmrTransaction::DELETE_STMT);
         query.parse();
 
         SimpleResult sr = query.execute(tx_id_no);
 
+        if (sr.rows() > 0)
+            bump_account_changes(txs.front().account_id, conn);
+
         return sr.rows();
     }
     catch (std::exception const& e)
@@ -116,6 +298,31 @@ MysqlTransactions::delete_tx(const uint64_t& tx_id_no, shared_ptr<mysqlpp::Conne
     return 0;
 }
 
+bool
+MysqlTransactions::select_for_heights(const uint64_t& account_id,
+                                      uint64_t h1, uint64_t h2,
+                                      vector<XmrTransaction>& txs,
+                                      shared_ptr<mysqlpp::Connection> conn)
+{
+    try
+    {
+        if (!conn) conn = MySqlConnectionPool::get().grab_shared();
+        Query query = conn->query(XmrTransaction::SELECT_FOR_HEIGHTS_STMT);
+        query.parse();
+
+        txs.clear();
+
+        query.storein(txs, account_id, h1, h2);
+
+        return !txs.empty();
+    }
+    catch (std::exception const& e)
+    {
+        MYSQL_EXCEPTION_MSG(e);
+    }
+
+    return false;
+}
 
 bool
 MysqlTransactions::exist(const uint64_t& account_id,
@@ -125,7 +332,9 @@ MysqlTransactions::exist(const uint64_t& account_id,
     {
         // mysqlpp::ScopedConnection cp(MySqlConnectionPool::get(), true);
         if (!conn) conn = MySqlConnectionPool::get().grab_shared();
-        Query query = conn->query(XmrTransaction::EXIST_STMT);
+        Query query = conn->query(MySqlConnectionPool::binary_keys
+                                  ? XmrTransaction::EXIST_BIN_STMT
+                                  : XmrTransaction::EXIST_STMT);
         query.parse();
 
         vector<XmrTransaction> outs;
@@ -148,6 +357,126 @@ MysqlTransactions::exist(const uint64_t& account_id,
 }
 
 
+bool
+MysqlOutpus::get_total_received_and_sent(const uint64_t& account_id,
+                                         uint64_t& total_received,
+                                         uint64_t& total_sent,
+                                         shared_ptr<mysqlpp::Connection> conn)
+{
+    try
+    {
+        if (!conn) conn = MySqlConnectionPool::get().grab_shared();
+        Query query = conn->query(XmrOutput::SUM_XMR_RECEIVED_AND_SENT);
+        query.parse();
+
+        StoreQueryResult sqr = query.store(account_id);
+
+        if (!sqr.empty())
+        {
+            total_received = sqr.at(0)["total_received"];
+            total_sent     = sqr.at(0)["total_sent"];
+            return true;
+        }
+    }
+    catch (std::exception const& e)
+    {
+        MYSQL_EXCEPTION_MSG(e);
+    }
+
+    return false;
+}
+
+bool
+MysqlOutpus::select_unlocked(const uint64_t& account_id,
+                             uint64_t dust_threshold,
+                             UnlockLimits const& limits,
+                             vector<XmrUnlockedOutput>& outs,
+                             shared_ptr<mysqlpp::Connection> conn)
+{
+    try
+    {
+        if (!conn) conn = MySqlConnectionPool::get().grab_shared();
+        Query query = conn->query(MySqlConnectionPool::binary_keys
+                                  ? XmrUnlockedOutput::SELECT_BIN_STMT
+                                  : XmrUnlockedOutput::SELECT_STMT);
+        query.parse();
+
+        outs.clear();
+
+        query.storein(outs, account_id, dust_threshold,
+                      limits.max_block_number, limits.max_unlock_height,
+                      limits.v2height, limits.max_unlock_time_v1,
+                      limits.max_unlock_time_v2);
+
+        return !outs.empty();
+    }
+    catch (std::exception const& e)
+    {
+        MYSQL_EXCEPTION_MSG(e);
+    }
+
+    return false;
+}
+
+bool
+MysqlOutpus::select_for_txs(vector<uint64_t> const& tx_ids,
+                            vector<XmrOutput>& outs,
+                            shared_ptr<mysqlpp::Connection> conn)
+{
+    outs.clear();
+
+    if (tx_ids.empty())
+        return false;
+
+    try
+    {
+        if (!conn) conn = MySqlConnectionPool::get().grab_shared();
+        Query query = conn->query(XmrOutput::SELECT_FOR_TXS_STMT);
+
+        for (size_t i = 0; i < tx_ids.size(); ++i)
+            query << (i > 0 ? ", " : "") << tx_ids[i];
+
+        query << ")";
+
+        query.storein(outs);
+
+        return !outs.empty();
+    }
+    catch (std::exception const& e)
+    {
+        MYSQL_EXCEPTION_MSG(e);
+    }
+
+    return false;
+}
+
+bool
+MysqlOutpus::select_known(const uint64_t& account_id,
+                          vector<XmrKnownOutput>& outs,
+                          shared_ptr<mysqlpp::Connection> conn)
+{
+    try
+    {
+        if (!conn) conn = MySqlConnectionPool::get().grab_shared();
+        Query query = conn->query(MySqlConnectionPool::binary_keys
+                                  ? XmrKnownOutput::SELECT_BIN_STMT
+                                  : XmrKnownOutput::SELECT_STMT);
+        query.parse();
+
+        outs.clear();
+
+        query.storein(outs, account_id);
+
+        return !outs.empty();
+    }
+    catch (std::exception const& e)
+    {
+        MYSQL_EXCEPTION_MSG(e);
+    }
+
+    return false;
+}
+
 bool
 MysqlTransactions::get_total_recieved(const uint64_t& account_id,
                                       uint64_t& amount, shared_ptr<mysqlpp::Connection> conn)
@@ -175,6 +504,37 @@ MysqlTransactions::get_total_recieved(const uint64_t& account_id,
     return false;
 }
 
+bool
+MysqlTransactions::get_totals(const uint64_t& account_id,
+                              uint64_t& total_received,
+                              uint64_t& total_received_unlocked,
+                              uint64_t& last_blockchain_tx_id,
+                              shared_ptr<mysqlpp::Connection> conn)
+{
+    try
+    {
+        if (!conn) conn = MySqlConnectionPool::get().grab_shared();
+        Query query = conn->query(XmrTransaction::SUM_XMR_RECEIVED_AND_UNLOCKED);
+        query.parse();
+
+        StoreQueryResult sqr = query.store(account_id);
+
+        if (!sqr.empty())
+        {
+            total_received          = sqr.at(0)["total_received"];
+            total_received_unlocked = sqr.at(0)["total_received_unlocked"];
+            last_blockchain_tx_id   = sqr.at(0)["last_blockchain_tx_id"];
+            return true;
+        }
+    }
+    catch (std::exception const& e)
+    {
+        MYSQL_EXCEPTION_MSG(e);
+    }
+
+    return false;
+}
+
 bool
 MysqlPayments::select_by_payment_id(const string& payment_id,
                                     vector<XmrPayment>& payments, shared_ptr<mysqlpp::Connection> conn)
@@ -249,9 +609,14 @@ MySqlAccounts::insert(const T& data_to_insert, shared_ptr<mysqlpp::Connection> c
         if (!conn) conn = MySqlConnectionPool::get().grab_shared();
         Query query = conn->query();
 
-        query.insert(data_to_insert);
+        SimpleResult sr;
 
-        SimpleResult sr = query.execute();
+        if (!MySqlConnectionPool::binary_keys
+                || !insert_binary(query, data_to_insert, sr))
+        {
+            query.insert(data_to_insert);
+            sr = query.execute();
+        }
 
         if (sr.rows() == 1)
             return sr.insert_id();
@@ -288,9 +653,17 @@ MySqlAccounts::insert(const vector<T>& data_to_insert, shared_ptr<mysqlpp::Conne
         if (!conn) conn = MySqlConnectionPool::get().grab_shared();
         Query query = conn->query();
 
-        query.insert(data_to_insert.begin(), data_to_insert.end());
+        if (data_to_insert.empty())
+            return 0;
 
-        SimpleResult sr = query.execute();
+        SimpleResult sr;
+
+        if (!MySqlConnectionPool::binary_keys
+                || !insert_binary(query, data_to_insert, sr))
+        {
+            query.insert(data_to_insert.begin(), data_to_insert.end());
+            sr = query.execute();
+        }
 
         return sr.rows();
 
@@ -312,6 +685,63 @@ template
 uint64_t MySqlAccounts::insert<XmrInput>(
         const vector<XmrInput>& data_to_insert, shared_ptr<mysqlpp::Connection> conn);
 
+template <typename T>
+bool
+MySqlAccounts::upsert(const vector<T>& data_to_upsert, uint64_t& no_of_affected,
+                      shared_ptr<mysqlpp::Connection> conn)
+{
+    no_of_affected = 0;
+
+    if (data_to_upsert.empty())
+        return true;
+
+    try
+    {
+        if (!conn) conn = MySqlConnectionPool::get().grab_shared();
+        Query query = conn->query();
+
+        SimpleResult sr;
+
+        // one statement for all rows
+        if (!MySqlConnectionPool::binary_keys
+                || !insert_binary(query, data_to_upsert, sr, true))
+        {
+            query.insert(data_to_upsert.begin(), data_to_upsert.end());
+
+            query << T::UPSERT_CLAUSE;
+
+            sr = query.execute();
+        }
+
+        no_of_affected = sr.rows();
+
+        // unchanged rows are not counted in sr.rows(), so
+        // only success of the statement is checked
+        return static_cast<bool>(sr);
+    }
+    catch (std::exception const& e)
+    {
+        MYSQL_EXCEPTION_MSG(e);
+    }
+
+    return false;
+}
+
+template
+bool MySqlAccounts::upsert<XmrTransaction>(
+        const vector<XmrTransaction>& data_to_upsert, uint64_t& no_of_affected,
+        shared_ptr<mysqlpp::Connection> conn);
+
+template
+bool MySqlAccounts::upsert<XmrOutput>(
+        const vector<XmrOutput>& data_to_upsert, uint64_t& no_of_affected,
+        shared_ptr<mysqlpp::Connection> conn);
+
+template
+bool MySqlAccounts::upsert<XmrInput>(
+        const vector<XmrInput>& data_to_upsert, uint64_t& no_of_affected,
+        shared_ptr<mysqlpp::Connection> conn);
+
 template <typename T, size_t query_no>
 bool
 MySqlAccounts::select(uint64_t account_id, vector<T>& selected_data, shared_ptr<mysqlpp::Connection> conn)
@@ -320,8 +750,7 @@ MySqlAccounts::select(uint64_t account_id, vector<T>& selected_data, shared_ptr<
     {
         // mysqlpp::ScopedConnection cp(MySqlConnectionPool::get(), true);
         if (!conn) conn = MySqlConnectionPool::get().grab_shared();
-        Query query = conn->query((query_no == 1
-                                   ? T::SELECT_STMT : T::SELECT_STMT2));
+        Query query = conn->query(query_no == 1 ? T::SELECT_STMT : T::SELECT_STMT2);
         query.parse();
 
         selected_data.clear();
@@ -366,6 +795,7 @@ template
 bool MySqlAccounts::select<XmrPayment>(uint64_t account_id,
         vector<XmrPayment>& selected_data, shared_ptr<mysqlpp::Connection> conn);
 
+
 template // this will use SELECT_STMT2 which selectes
          // based on transaction id, not account_id,
 bool MySqlAccounts::select<XmrInput, 2>(uint64_t tx_id,
@@ -404,6 +834,46 @@ template
 bool MySqlAccounts::update<XmrPayment>(
         XmrPayment const& orginal_row, XmrPayment const& new_row, shared_ptr<mysqlpp::Connection> conn);
 
+template <typename T>
+bool
+MySqlAccounts::select_since(uint64_t account_id, uint64_t since_id,
+                            vector<T>& selected_data,
+                            shared_ptr<mysqlpp::Connection> conn)
+{
+    try
+    {
+        if (!conn) conn = MySqlConnectionPool::get().grab_shared();
+        Query query = conn->query(MySqlConnectionPool::binary_keys
+                                  ? T::SELECT_SINCE_BIN_STMT
+                                  : T::SELECT_SINCE_STMT);
+        query.parse();
+
+        selected_data.clear();
+
+        query.storein(selected_data, account_id, since_id);
+
+        return !selected_data.empty();
+    }
+    catch (std::exception const& e)
+    {
+        MYSQL_EXCEPTION_MSG(e);
+    }
+
+    return false;
+}
+
+template
+bool MySqlAccounts::select_since<XmrTransactionWithOutsAndIns>(
+        uint64_t account_id, uint64_t since_id,
+        vector<XmrTransactionWithOutsAndIns>& selected_data,
+        shared_ptr<mysqlpp::Connection> conn);
+
+template
+bool MySqlAccounts::select_since<XmrSpentOutput>(
+        uint64_t account_id, uint64_t since_id,
+        vector<XmrSpentOutput>& selected_data,
+        shared_ptr<mysqlpp::Connection> conn);
+
 template <typename T>
 bool
 MySqlAccounts::select_for_tx(uint64_t tx_id, vector<T>& selected_data, shared_ptr<mysqlpp::Connection> conn)
@@ -601,6 +1071,69 @@ MySqlAccounts::delete_tx(const uint64_t& tx_id_no, shared_ptr<mysqlpp::Connectio
     return mysql_tx->delete_tx(tx_id_no, conn);
 }
 
+bool
+MySqlAccounts::get_changes(const uint64_t& account_id, uint64_t& changes,
+                           shared_ptr<mysqlpp::Connection> conn)
+{
+    try
+    {
+        if (!conn) conn = MySqlConnectionPool::get().grab_shared();
+        Query query = conn->query(XmrAccount::SELECT_CHANGES_STMT);
+        query.parse();
+
+        StoreQueryResult sqr = query.store(account_id);
+
+        changes = 0;
+
+        // no row until first change of the account
+        if (!sqr.empty())
+            changes = sqr.at(0)["changes"];
+
+        return true;
+    }
+    catch (std::exception const& e)
+    {
+        MYSQL_EXCEPTION_MSG(e);
+    }
+
+    return false;
+}
+
+bool
+MySqlAccounts::bump_changes(const uint64_t& account_id,
+                            shared_ptr<mysqlpp::Connection> conn)
+{
+    try
+    {
+        if (!conn) conn = MySqlConnectionPool::get().grab_shared();
+
+        return bump_account_changes(account_id, conn);
+    }
+    catch (std::exception const& e)
+    {
+        MYSQL_EXCEPTION_MSG(e);
+    }
+
+    return false;
+}
+
+bool
+MySqlAccounts::select_txs_for_heights(const uint64_t& account_id,
+                                      uint64_t h1, uint64_t h2,
+                                      vector<XmrTransaction>& txs,
+                                      shared_ptr<mysqlpp::Connection> conn)
+{
+    return mysql_tx->select_for_heights(account_id, h1, h2, txs, conn);
+}
+
+bool
+MySqlAccounts::select_outputs_for_txs(vector<uint64_t> const& tx_ids,
+                                      vector<XmrOutput>& outs,
+                                      shared_ptr<mysqlpp::Connection> conn)
+{
+    return mysql_out->select_for_txs(tx_ids, outs, conn);
+}
+
 bool
 MySqlAccounts::select_payment_by_id(const string& payment_id,
                                     vector<XmrPayment>& payments, shared_ptr<mysqlpp::Connection> conn)
@@ -615,6 +1148,47 @@ MySqlAccounts::get_total_recieved(const uint64_t& account_id,
     return mysql_tx->get_total_recieved(account_id, amount, conn);
 }
 
+bool
+MySqlAccounts::get_txs_totals(const uint64_t& account_id,
+                              uint64_t& total_received,
+                              uint64_t& total_received_unlocked,
+                              uint64_t& last_blockchain_tx_id,
+                              shared_ptr<mysqlpp::Connection> conn)
+{
+    return mysql_tx->get_totals(account_id, total_received,
+                                total_received_unlocked,
+                                last_blockchain_tx_id, conn);
+}
+
+bool
+MySqlAccounts::get_total_received_and_sent(const uint64_t& account_id,
+                                           uint64_t& total_received,
+                                           uint64_t& total_sent,
+                                           shared_ptr<mysqlpp::Connection> conn)
+{
+    return mysql_out->get_total_received_and_sent(
+                account_id, total_received, total_sent, conn);
+}
+
+bool
+MySqlAccounts::select_unlocked_outputs(const uint64_t& account_id,
+                                       uint64_t dust_threshold,
+                                       UnlockLimits const& limits,
+                                       vector<XmrUnlockedOutput>& outs,
+                                       shared_ptr<mysqlpp::Connection> conn)
+{
+    return mysql_out->select_unlocked(account_id, dust_threshold,
+                                      limits, outs, conn);
+}
+
+bool
+MySqlAccounts::select_known_outputs(const uint64_t& account_id,
+                                    vector<XmrKnownOutput>& outs,
+                                    shared_ptr<mysqlpp::Connection> conn)
+{
+    return mysql_out->select_known(account_id, outs, conn);
+}
+
 void
 MySqlAccounts::set_bc_status_provider(
         shared_ptr<CurrentBlockchainStatus> bc_status_provider)
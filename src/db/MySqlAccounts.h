@@ -24,6 +24,9 @@ using namespace nlohmann;
 
 
 class XmrTransactionWithOutsAndIns;
+class XmrSpentOutput;
+class XmrUnlockedOutput;
+class XmrKnownOutput;
 class XmrInput;
 class XmrOutput;
 class XmrTransaction;
@@ -31,6 +34,7 @@ class XmrPayment;
 class XmrAccount;
 class Table;
 class CurrentBlockchainStatus;
+struct UnlockLimits;
 
 
 class MysqlInputs
@@ -47,6 +51,23 @@ class MysqlOutpus
 public:
     bool
     exist(const string& output_public_key_str, XmrOutput& out, shared_ptr<mysqlpp::Connection> conn = nullptr);
+
+    bool
+    get_total_received_and_sent(const uint64_t& account_id, uint64_t& total_received,
+                                uint64_t& total_sent, shared_ptr<mysqlpp::Connection> conn = nullptr);
+
+    bool
+    select_unlocked(const uint64_t& account_id, uint64_t dust_threshold,
+                    UnlockLimits const& limits, vector<XmrUnlockedOutput>& outs,
+                    shared_ptr<mysqlpp::Connection> conn = nullptr);
+
+    bool
+    select_for_txs(vector<uint64_t> const& tx_ids,
+                   vector<XmrOutput>& outs, shared_ptr<mysqlpp::Connection> conn = nullptr);
+
+    bool
+    select_known(const uint64_t& account_id, vector<XmrKnownOutput>& outs,
+                 shared_ptr<mysqlpp::Connection> conn = nullptr);
 };
 
 
@@ -60,11 +81,20 @@ public:
     uint64_t
     delete_tx(const uint64_t& tx_id_no, shared_ptr<mysqlpp::Connection> conn = nullptr);
 
+    bool
+    select_for_heights(const uint64_t& account_id, uint64_t h1, uint64_t h2,
+                       vector<XmrTransaction>& txs, shared_ptr<mysqlpp::Connection> conn = nullptr);
+
     bool
     exist(const uint64_t& account_id, const string& tx_hash_str, XmrTransaction& tx, shared_ptr<mysqlpp::Connection> conn = nullptr);
 
     bool
     get_total_recieved(const uint64_t& account_id, uint64_t& amount, shared_ptr<mysqlpp::Connection> conn = nullptr);
+
+    bool
+    get_totals(const uint64_t& account_id, uint64_t& total_received,
+               uint64_t& total_received_unlocked, uint64_t& last_blockchain_tx_id,
+               shared_ptr<mysqlpp::Connection> conn = nullptr);
 };
 
 class MysqlPayments
@@ -102,6 +132,15 @@ public:
     uint64_t
     insert(const vector<T>& data_to_insert, shared_ptr<mysqlpp::Connection> conn = nullptr);
 
+    // inserts rows, or updates existing ones with the same unique
+    // key using T::UPSERT_CLAUSE. rows which dont change are not
+    // written. no_of_affected is as counted by mysql: 1 for each
+    // inserted row, 2 for each changed one and 0 for unchanged ones
+    template <typename T>
+    bool
+    upsert(const vector<T>& data_to_upsert, uint64_t& no_of_affected,
+           shared_ptr<mysqlpp::Connection> conn = nullptr);
+
     /**
      *
      * @tparam T
@@ -118,6 +157,12 @@ public:
     bool
     update(T const& orginal_row, T const& new_row, shared_ptr<mysqlpp::Connection> conn = nullptr);
 
+    // same as select, but using T::SELECT_SINCE_STMT
+    // which also takes the id of last row seen before
+    template <typename T>
+    bool
+    select_since(uint64_t account_id, uint64_t since_id, vector<T>& selected_data, shared_ptr<mysqlpp::Connection> conn = nullptr);
+
     template <typename T>
     bool
     select_for_tx(uint64_t tx_id, vector<T>& selected_data, shared_ptr<mysqlpp::Connection> conn = nullptr);
@@ -148,6 +193,23 @@ public:
     uint64_t
     delete_tx(const uint64_t& tx_id_no, shared_ptr<mysqlpp::Connection> conn = nullptr);
 
+    // number of updates and deletes of rows of the account, which
+    // are counted by delete_tx, mark_tx_spendable and bump_changes
+    bool
+    get_changes(const uint64_t& account_id, uint64_t& changes, shared_ptr<mysqlpp::Connection> conn = nullptr);
+
+    bool
+    bump_changes(const uint64_t& account_id, shared_ptr<mysqlpp::Connection> conn = nullptr);
+
+    bool
+    select_txs_for_heights(const uint64_t& account_id, uint64_t h1, uint64_t h2,
+                           vector<XmrTransaction>& txs, shared_ptr<mysqlpp::Connection> conn = nullptr);
+
+    // outputs of txs with the given ids
+    bool
+    select_outputs_for_txs(vector<uint64_t> const& tx_ids,
+                           vector<XmrOutput>& outs, shared_ptr<mysqlpp::Connection> conn = nullptr);
+
     bool
     select_payment_by_id(const string& payment_id, vector<XmrPayment>& payments, shared_ptr<mysqlpp::Connection> conn = nullptr);
 
@@ -157,6 +219,32 @@ public:
     bool
     get_total_recieved(const uint64_t& account_id, uint64_t& amount, shared_ptr<mysqlpp::Connection> conn = nullptr);
 
+    // sums of total_received of all txs of the account and of its
+    // spendable txs, and the highest blockchain_tx_id
+    bool
+    get_txs_totals(const uint64_t& account_id, uint64_t& total_received,
+                   uint64_t& total_received_unlocked, uint64_t& last_blockchain_tx_id,
+                   shared_ptr<mysqlpp::Connection> conn = nullptr);
+
+    // sums of amounts of all outputs of the account
+    // and of all its inputs
+    bool
+    get_total_received_and_sent(const uint64_t& account_id, uint64_t& total_received,
+                                uint64_t& total_sent, shared_ptr<mysqlpp::Connection> conn = nullptr);
+
+    // outputs of unlocked txs with amounts not below dust_threshold,
+    // together with key images of inputs which may spend them
+    bool
+    select_unlocked_outputs(const uint64_t& account_id, uint64_t dust_threshold,
+                            UnlockLimits const& limits, vector<XmrUnlockedOutput>& outs,
+                            shared_ptr<mysqlpp::Connection> conn = nullptr);
+
+    // outputs of the account with binary out_pub_key and
+    // is_rct of their txs, to populate known outputs of TxSearch
+    bool
+    select_known_outputs(const uint64_t& account_id, vector<XmrKnownOutput>& outs,
+                         shared_ptr<mysqlpp::Connection> conn = nullptr);
+
     /**
      * DONT use!!!
      *
@@ -16,5 +16,6 @@ size_t MySqlConnectionPool::port;
 string MySqlConnectionPool::username;
 string MySqlConnectionPool::password;
 string MySqlConnectionPool::dbname;
+bool MySqlConnectionPool::binary_keys {false};
 
 }
\ No newline at end of file
@@ -32,6 +32,10 @@ public:
     static string password;
     static string dbname;
 
+    // Transactions, Outputs and Inputs are views of tables with
+    // binary keys and hashes. see sql/binary_keys.sql
+    static bool binary_keys;
+
     static MySqlConnectionPool &get() {
         return _inst;
     }
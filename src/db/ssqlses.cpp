@@ -114,6 +114,109 @@ ostream& operator<< (std::ostream& os, const XmrInput& out)
     return os;
 };
 
+XmrTransaction
+XmrTransactionWithOutsAndIns::get_transaction() const
+{
+    XmrTransaction tx;
+
+    tx.id               = id;
+    tx.hash             = hash;
+    tx.prefix_hash      = prefix_hash;
+    tx.tx_pub_key       = tx_pub_key;
+    tx.account_id       = account_id;
+    tx.blockchain_tx_id = blockchain_tx_id;
+    tx.total_received   = total_received;
+    tx.total_sent       = total_sent;
+    tx.unlock_time      = unlock_time;
+    tx.height           = height;
+    tx.coinbase         = coinbase;
+    tx.is_rct           = is_rct;
+    tx.rct_type         = rct_type;
+    tx.spendable        = spendable;
+    tx.payment_id       = payment_id;
+    tx.mixin            = mixin;
+    tx.timestamp        = timestamp;
+
+    return tx;
+}
+
+json
+XmrTransactionWithOutsAndIns::spent_output() const
+{
+    json j {{"amount"     , std::to_string(spent_amount.data)},
+            {"key_image"  , key_image.data},
+            {"tx_pub_key" , out_tx_pub_key.data},
+            {"out_index"  , out_index.data},
+            {"mixin"      , out_mixin.data}
+    };
+
+    return j;
+}
+
+json
+XmrTransactionWithOutsAndIns::to_json() const
+{
+    json j = get_transaction().to_json();
+
+    if (has_spent_output())
+        j["spent_output"] = spent_output();
+
+    return j;
+}
+
+json
+XmrSpentOutput::to_json() const
+{
+    json j {{"amount"     , std::to_string(amount)},
+            {"key_image"  , key_image},
+            {"tx_pub_key" , tx_pub_key},
+            {"out_index"  , out_index},
+            {"mixin"      , mixin}
+    };
+
+    return j;
+}
+
+json
+XmrUnlockedOutput::to_json() const
+{
+    json j {{"id"              , id},
+            {"tx_id"           , tx_id},
+            {"out_pub_key"     , out_pub_key},
+            {"amount"          , amount},
+            {"global_index"    , global_index},
+            {"out_index"       , out_index},
+            {"tx_hash"         , tx_hash},
+            {"height"          , height},
+            {"key_image"       , key_image.is_null
+                                    ? json() : json(key_image.data)}
+    };
+
+    return j;
+}
+
+json
+XmrKnownOutput::to_json() const
+{
+    static constexpr char hex[] = "0123456789abcdef";
+
+    string out_pub_key_hex;
+
+    for (unsigned char c: out_pub_key)
+    {
+        out_pub_key_hex += hex[c >> 4];
+        out_pub_key_hex += hex[c & 0x0f];
+    }
+
+    json j {{"out_pub_key"     , out_pub_key_hex},
+            {"amount"          , amount},
+            {"global_index"    , global_index},
+            {"is_rct"          , bool {is_rct}}
+    };
+
+    return j;
+}
+
 json
 XmrPayment::to_json() const
 {
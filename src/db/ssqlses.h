@@ -68,6 +68,20 @@ struct XmrAccount : public Accounts, Table
                                 (%0q, %1q, %2q, %3q, %4q, %5q);
     )";
 
+    // number of updates and deletes of rows of the account. clients
+    // keep it in their since cursors, as such changes cant be found
+    // by ids of rows. its in its own table, because XmrAccount
+    // rows are updated only if all their columns are unchanged
+    static constexpr const char* SELECT_CHANGES_STMT = R"(
+        SELECT `changes` FROM `AccountChanges` WHERE `account_id` = (%0q)
+    )";
+
+    static constexpr const char* BUMP_CHANGES_STMT = R"(
+        INSERT INTO `AccountChanges` (`account_id`, `changes`)
+                                VALUES (%0q, 1)
+        ON DUPLICATE KEY UPDATE `changes` = `changes` + 1
+    )";
+
     using Accounts::Accounts;
 
     // viewkey is not stored in mysql db or anywhere
@@ -120,10 +134,26 @@ struct XmrTransaction : public Transactions, Table
         SELECT * FROM `Transactions` WHERE `account_id` = (%0q) AND `hash` = (%1q)
     )";
 
+    // with binary keys, Transactions is a view with hex hash, so
+    // we look up the id in its table to use the index on hash
+    static constexpr const char* EXIST_BIN_STMT = R"(
+        SELECT * FROM `Transactions` WHERE `id` =
+            (SELECT `id` FROM `TransactionsBin`
+                    WHERE `account_id` = (%0q) AND `hash` = UNHEX(%1q))
+    )";
+
     static constexpr const char* DELETE_STMT = R"(
        DELETE FROM `Transactions` WHERE `id` = (%0q)
     )";
 
+    // txs of the account in blocks from %1q to %2q. used
+    // by TxSearch to write txs of a scan window at once
+    static constexpr const char* SELECT_FOR_HEIGHTS_STMT = R"(
+        SELECT * FROM `Transactions` WHERE `account_id` = (%0q)
+                                       AND `height` >= (%1q)
+                                       AND `height` <= (%2q)
+    )";
+
     static constexpr const char* INSERT_STMT = R"(
         INSERT IGNORE INTO `Transactions` (`hash`, `prefix_hash`, `tx_pub_key`, `account_id`, 
                                            `blockchain_tx_id`,
@@ -139,6 +169,46 @@ struct XmrTransaction : public Transactions, Table
                                         %13q, %14q, %15q);
     )";
 
+    // with binary keys, rows cant be inserted into the view. rows
+    // are appended to it as (UNHEX(hash), ...), see insert_binary.
+    // its preceded by INSERT IGNORE, as INSERT_STMT, or by INSERT
+    // when UPSERT_CLAUSE is appended
+    static constexpr const char* BIN_INTO_CLAUSE = R"(
+        INTO `TransactionsBin` (`hash`, `prefix_hash`, `tx_pub_key`,
+                                `account_id`, `blockchain_tx_id`,
+                                `total_received`, `total_sent`,
+                                `unlock_time`, `height`, `coinbase`,
+                                `is_rct`, `rct_type`, `spendable`,
+                                `payment_id`, `mixin`, `timestamp`)
+                     VALUES
+    )";
+
+    // appended to inserts, so that rescanned txs are updated in
+    // place, keyed by (hash, account_id). rows which dont change
+    // are not written at all. spendable and timestamp are set by
+    // MARK_AS_SPENDABLE_STMT, so they are kept unless the tx got
+    // into other block. they must be assigned before height, as
+    // mysql uses already updated values in later assignments
+    static constexpr const char* UPSERT_CLAUSE = R"(
+        ON DUPLICATE KEY UPDATE
+            `spendable`        = IF(`height` = VALUES(`height`),
+                                    `spendable`, VALUES(`spendable`)),
+            `timestamp`        = IF(`height` = VALUES(`height`),
+                                    `timestamp`, VALUES(`timestamp`)),
+            `prefix_hash`      = VALUES(`prefix_hash`),
+            `tx_pub_key`       = VALUES(`tx_pub_key`),
+            `blockchain_tx_id` = VALUES(`blockchain_tx_id`),
+            `total_received`   = VALUES(`total_received`),
+            `total_sent`       = VALUES(`total_sent`),
+            `unlock_time`      = VALUES(`unlock_time`),
+            `height`           = VALUES(`height`),
+            `coinbase`         = VALUES(`coinbase`),
+            `is_rct`           = VALUES(`is_rct`),
+            `rct_type`         = VALUES(`rct_type`),
+            `payment_id`       = VALUES(`payment_id`),
+            `mixin`            = VALUES(`mixin`)
+    )";
+
     static constexpr const char* MARK_AS_SPENDABLE_STMT = R"(
        UPDATE `Transactions` SET `spendable` = 1,  `timestamp` = CURRENT_TIMESTAMP
                              WHERE `id` = %0q;
@@ -156,6 +226,15 @@ struct XmrTransaction : public Transactions, Table
                GROUP BY `account_id`
     )";
 
+    static constexpr const char* SUM_XMR_RECEIVED_AND_UNLOCKED = R"(
+        SELECT COALESCE(SUM(`total_received`), 0) AS total_received,
+               COALESCE(SUM(IF(`spendable`, `total_received`, 0)), 0)
+                    AS total_received_unlocked,
+               COALESCE(MAX(`blockchain_tx_id`), 0) AS last_blockchain_tx_id
+               FROM `Transactions`
+               WHERE `account_id` = %0q
+    )";
+
 
 
 
@@ -201,10 +280,33 @@ struct XmrOutput : public Outputs, Table
       SELECT * FROM `Outputs` WHERE `id` = (%0q)
     )";
 
+    // outputs of given txs. ids of the txs, separated by commas,
+    // and closing bracket are appended to it
+    static constexpr const char* SELECT_FOR_TXS_STMT = R"(
+      SELECT * FROM `Outputs` WHERE `tx_id` IN (
+    )";
+
     static constexpr const char* EXIST_STMT = R"(
       SELECT * FROM `Outputs` WHERE `out_pub_key` = (%0q)
     )";
 
+    // with binary keys, Outputs is a view with hex keys, so
+    // we look up the id in its table to use the index on out_pub_key
+    static constexpr const char* EXIST_BIN_STMT = R"(
+      SELECT * FROM `Outputs` WHERE `id` =
+            (SELECT `id` FROM `OutputsBin` WHERE `out_pub_key` = UNHEX(%0q))
+    )";
+
+    // outputs of the account and amounts of inputs which spend them.
+    // inputs are only stored for outputs of the same account
+    static constexpr const char* SUM_XMR_RECEIVED_AND_SENT = R"(
+      SELECT
+        (SELECT COALESCE(SUM(`amount`), 0) FROM `Outputs`
+                WHERE `account_id` = %0q) AS total_received,
+        (SELECT COALESCE(SUM(`amount`), 0) FROM `Inputs`
+                WHERE `account_id` = %0q) AS total_sent
+    )";
+
     static constexpr const char* INSERT_STMT = R"(
       INSERT IGNORE INTO `Outputs` (`account_id`, `tx_id`, `out_pub_key`,
                                      `tx_pub_key`,
@@ -218,6 +320,32 @@ struct XmrOutput : public Outputs, Table
                                     %9q, %10q, %11q);
     )";
 
+    // with binary keys, rows cant be inserted into the view. rows
+    // are appended to it, see insert_binary
+    static constexpr const char* BIN_INTO_CLAUSE = R"(
+      INTO `OutputsBin` (`account_id`, `tx_id`, `out_pub_key`,
+                         `rct_outpk`, `rct_mask`, `rct_amount`,
+                         `tx_pub_key`, `amount`, `global_index`,
+                         `out_index`, `mixin`, `timestamp`)
+                 VALUES
+    )";
+
+    // keyed by out_pub_key
+    static constexpr const char* UPSERT_CLAUSE = R"(
+      ON DUPLICATE KEY UPDATE
+            `account_id`   = VALUES(`account_id`),
+            `tx_id`        = VALUES(`tx_id`),
+            `tx_pub_key`   = VALUES(`tx_pub_key`),
+            `rct_outpk`    = VALUES(`rct_outpk`),
+            `rct_mask`     = VALUES(`rct_mask`),
+            `rct_amount`   = VALUES(`rct_amount`),
+            `amount`       = VALUES(`amount`),
+            `global_index` = VALUES(`global_index`),
+            `out_index`    = VALUES(`out_index`),
+            `mixin`        = VALUES(`mixin`),
+            `timestamp`    = VALUES(`timestamp`)
+    )";
+
 
 
     using Outputs::Outputs;
@@ -272,6 +400,23 @@ struct XmrInput : public Inputs, Table
                                 %3q, %4q, %5q);
     )";
 
+    // with binary keys, rows cant be inserted into the view. rows
+    // are appended to it, see insert_binary
+    static constexpr const char* BIN_INTO_CLAUSE = R"(
+      INTO `InputsBin` (`account_id`, `tx_id`, `output_id`,
+                        `key_image`, `amount`, `timestamp`)
+                VALUES
+    )";
+
+    // keyed by (output_id, key_image)
+    static constexpr const char* UPSERT_CLAUSE = R"(
+      ON DUPLICATE KEY UPDATE
+            `account_id` = VALUES(`account_id`),
+            `tx_id`      = VALUES(`tx_id`),
+            `amount`     = VALUES(`amount`),
+            `timestamp`  = VALUES(`timestamp`)
+    )";
+
     using Inputs::Inputs;
 
     string table_name() const override { return this->table();};
@@ -280,6 +425,290 @@ struct XmrInput : public Inputs, Table
 
 };
 
+// not a table, but a row of Transactions joined with their
+// Inputs and Outputs spent in them. a tx without inputs is a single
+// row with null input fields. a tx with inputs has one row per
+// input. fields are populated by names, so columns from
+// Inputs and Outputs are aliased in SELECT_SINCE_STMT
+sql_create_22(TransactionsWithOutsAndIns, 1, 0,
+              sql_bigint_unsigned_null, id,
+              sql_varchar             , hash,
+              sql_varchar             , prefix_hash,
+              sql_varchar             , tx_pub_key,
+              sql_bigint_unsigned     , account_id,
+              sql_bigint_unsigned     , blockchain_tx_id,
+              sql_bigint_unsigned     , total_received,
+              sql_bigint_unsigned     , total_sent,
+              sql_bigint_unsigned     , unlock_time,
+              sql_bigint_unsigned     , height,
+              sql_bool                , coinbase,
+              sql_bool                , is_rct,
+              sql_int                 , rct_type,
+              sql_bool                , spendable,
+              sql_varchar             , payment_id,
+              sql_bigint_unsigned     , mixin,
+              sql_timestamp           , timestamp,
+              sql_varchar_null        , key_image,
+              sql_bigint_unsigned_null, spent_amount,
+              sql_varchar_null        , out_tx_pub_key,
+              sql_bigint_unsigned_null, out_index,
+              sql_bigint_unsigned_null, out_mixin);
+
+
+struct XmrTransactionWithOutsAndIns : public TransactionsWithOutsAndIns, Table
+{
+
+    // txs added after the given tx id, and txs which are not yet
+    // spendable, as these can still change or be removed. with
+    // tx id of 0 all txs are returned. rows of a given tx are next
+    // to each other
+    static constexpr const char* SELECT_SINCE_STMT = R"(
+       SELECT `t`.*,
+              `i`.`key_image`   AS `key_image`,
+              `i`.`amount`      AS `spent_amount`,
+              `o`.`tx_pub_key`  AS `out_tx_pub_key`,
+              `o`.`out_index`   AS `out_index`,
+              `o`.`mixin`       AS `out_mixin`
+       FROM `Transactions` AS `t`
+       LEFT JOIN `Inputs`  AS `i` ON `i`.`tx_id` = `t`.`id`
+       LEFT JOIN `Outputs` AS `o` ON `o`.`id` = `i`.`output_id`
+       WHERE `t`.`account_id` = (%0q)
+         AND (`t`.`id` > (%1q) OR `t`.`spendable` = 0)
+       ORDER BY `t`.`id`, `i`.`id`
+    )";
+
+    // same, but with binary keys. tables are joined directly
+    // instead of their views, so keys are converted to hex only
+    // in the returned rows
+    static constexpr const char* SELECT_SINCE_BIN_STMT = R"(
+       SELECT `t`.`id`,
+              LOWER(HEX(`t`.`hash`))        AS `hash`,
+              LOWER(HEX(`t`.`prefix_hash`)) AS `prefix_hash`,
+              LOWER(HEX(`t`.`tx_pub_key`))  AS `tx_pub_key`,
+              `t`.`account_id`, `t`.`blockchain_tx_id`,
+              `t`.`total_received`, `t`.`total_sent`,
+              `t`.`unlock_time`, `t`.`height`, `t`.`coinbase`,
+              `t`.`is_rct`, `t`.`rct_type`, `t`.`spendable`,
+              `t`.`payment_id`, `t`.`mixin`, `t`.`timestamp`,
+              LOWER(HEX(`i`.`key_image`))   AS `key_image`,
+              `i`.`amount`                  AS `spent_amount`,
+              LOWER(HEX(`o`.`tx_pub_key`))  AS `out_tx_pub_key`,
+              `o`.`out_index`               AS `out_index`,
+              `o`.`mixin`                   AS `out_mixin`
+       FROM `TransactionsBin` AS `t`
+       LEFT JOIN `InputsBin`  AS `i` ON `i`.`tx_id` = `t`.`id`
+       LEFT JOIN `OutputsBin` AS `o` ON `o`.`id` = `i`.`output_id`
+       WHERE `t`.`account_id` = (%0q)
+         AND (`t`.`id` > (%1q) OR `t`.`spendable` = 0)
+       ORDER BY `t`.`id`, `i`.`id`
+    )";
+
+    using TransactionsWithOutsAndIns::TransactionsWithOutsAndIns;
+
+    // Transactions part of the row
+    XmrTransaction
+    get_transaction() const;
+
+    // the row has an input of the tx
+    bool
+    has_input() const
+    {
+        return !key_image.is_null;
+    }
+
+    // the input's output is also there
+    bool
+    has_spent_output() const
+    {
+        return !key_image.is_null && !out_index.is_null;
+    }
+
+    // same format as spent_outputs in get_address_txs
+    json
+    spent_output() const;
+
+    string table_name() const override { return this->table();};
+
+    json to_json() const override;
+
+};
+
+// not a table. inputs of an account joined with the
+// outputs they spend, as returned in spent_outputs by
+// get_address_info
+sql_create_6(SpentOutputs, 1, 0,
+             sql_bigint_unsigned     , id,
+             sql_bigint_unsigned     , amount,
+             sql_varchar             , key_image,
+             sql_varchar             , tx_pub_key,
+             sql_bigint_unsigned     , out_index,
+             sql_bigint_unsigned     , mixin);
+
+
+struct XmrSpentOutput : public SpentOutputs, Table
+{
+
+    // only inputs added after the given input id.
+    // with input id of 0 all of them are returned
+    static constexpr const char* SELECT_SINCE_STMT = R"(
+       SELECT `i`.`id`         AS `id`,
+              `i`.`amount`     AS `amount`,
+              `i`.`key_image`  AS `key_image`,
+              `o`.`tx_pub_key` AS `tx_pub_key`,
+              `o`.`out_index`  AS `out_index`,
+              `o`.`mixin`      AS `mixin`
+       FROM `Outputs` AS `o`
+       INNER JOIN `Inputs` AS `i` ON `i`.`output_id` = `o`.`id`
+       WHERE `o`.`account_id` = (%0q)
+         AND `i`.`id` > (%1q)
+       ORDER BY `o`.`tx_id`, `o`.`id`, `i`.`id`
+    )";
+
+    // same, but with binary keys
+    static constexpr const char* SELECT_SINCE_BIN_STMT = R"(
+       SELECT `i`.`id`                     AS `id`,
+              `i`.`amount`                 AS `amount`,
+              LOWER(HEX(`i`.`key_image`))  AS `key_image`,
+              LOWER(HEX(`o`.`tx_pub_key`)) AS `tx_pub_key`,
+              `o`.`out_index`              AS `out_index`,
+              `o`.`mixin`                  AS `mixin`
+       FROM `OutputsBin` AS `o`
+       INNER JOIN `InputsBin` AS `i` ON `i`.`output_id` = `o`.`id`
+       WHERE `o`.`account_id` = (%0q)
+         AND `i`.`id` > (%1q)
+       ORDER BY `o`.`tx_id`, `o`.`id`, `i`.`id`
+    )";
+
+    using SpentOutputs::SpentOutputs;
+
+    string table_name() const override { return this->table();};
+
+    json to_json() const override;
+
+};
+
+// not a table. unlocked outputs of an account, with fields
+// of their txs, joined with inputs which may spend them. an output
+// without inputs is a single row with null key_image, otherwise
+// there is one row per input.
+sql_create_17(UnlockedOutputs, 1, 0,
+              sql_bigint_unsigned     , id,
+              sql_bigint_unsigned     , tx_id,
+              sql_varchar             , out_pub_key,
+              sql_varchar             , rct_outpk,
+              sql_varchar             , rct_mask,
+              sql_varchar             , rct_amount,
+              sql_bigint_unsigned     , amount,
+              sql_bigint_unsigned     , global_index,
+              sql_bigint_unsigned     , out_index,
+              sql_timestamp           , timestamp,
+              sql_varchar             , tx_hash,
+              sql_varchar             , tx_prefix_hash,
+              sql_varchar             , tx_pub_key,
+              sql_bigint_unsigned     , height,
+              sql_bool                , is_rct,
+              sql_int                 , rct_type,
+              sql_varchar_null        , key_image);
+
+
+struct XmrUnlockedOutput : public UnlockedOutputs, Table
+{
+
+    // %0q account_id, %1q dust_threshold, %2q max_block_number,
+    // %3q max_unlock_height, %4q v2height, %5q max_unlock_time_v1,
+    // %6q max_unlock_time_v2. the unlock_time conditions are
+    // same as in TxUnlockChecker::is_unlocked
+    static constexpr const char* SELECT_STMT = R"(
+       SELECT `o`.`id`, `o`.`tx_id`, `o`.`out_pub_key`,
+              `o`.`rct_outpk`, `o`.`rct_mask`, `o`.`rct_amount`,
+              `o`.`amount`, `o`.`global_index`, `o`.`out_index`,
+              `o`.`timestamp`,
+              `t`.`hash`        AS `tx_hash`,
+              `t`.`prefix_hash` AS `tx_prefix_hash`,
+              `t`.`tx_pub_key`  AS `tx_pub_key`,
+              `t`.`height`, `t`.`is_rct`, `t`.`rct_type`,
+              `i`.`key_image`   AS `key_image`
+       FROM `Outputs` AS `o`
+       INNER JOIN `Transactions` AS `t` ON `t`.`id` = `o`.`tx_id`
+       LEFT JOIN `Inputs` AS `i` ON `i`.`output_id` = `o`.`id`
+       WHERE `o`.`account_id` = %0q
+         AND `o`.`amount` >= %1q
+         AND ((`t`.`unlock_time` < %2q AND `t`.`unlock_time` <= %3q)
+              OR (`t`.`unlock_time` >= %2q
+                  AND `t`.`unlock_time` <= IF(`t`.`height` < %4q, %5q, %6q)))
+       ORDER BY `t`.`id`, `o`.`id`, `i`.`id`
+    )";
+
+    // same, but with binary keys
+    static constexpr const char* SELECT_BIN_STMT = R"(
+       SELECT `o`.`id`, `o`.`tx_id`,
+              LOWER(HEX(`o`.`out_pub_key`)) AS `out_pub_key`,
+              LOWER(HEX(`o`.`rct_outpk`))   AS `rct_outpk`,
+              LOWER(HEX(`o`.`rct_mask`))    AS `rct_mask`,
+              LOWER(HEX(`o`.`rct_amount`))  AS `rct_amount`,
+              `o`.`amount`, `o`.`global_index`, `o`.`out_index`,
+              `o`.`timestamp`,
+              LOWER(HEX(`t`.`hash`))        AS `tx_hash`,
+              LOWER(HEX(`t`.`prefix_hash`)) AS `tx_prefix_hash`,
+              LOWER(HEX(`t`.`tx_pub_key`))  AS `tx_pub_key`,
+              `t`.`height`, `t`.`is_rct`, `t`.`rct_type`,
+              LOWER(HEX(`i`.`key_image`))   AS `key_image`
+       FROM `OutputsBin` AS `o`
+       INNER JOIN `TransactionsBin` AS `t` ON `t`.`id` = `o`.`tx_id`
+       LEFT JOIN `InputsBin` AS `i` ON `i`.`output_id` = `o`.`id`
+       WHERE `o`.`account_id` = %0q
+         AND `o`.`amount` >= %1q
+         AND ((`t`.`unlock_time` < %2q AND `t`.`unlock_time` <= %3q)
+              OR (`t`.`unlock_time` >= %2q
+                  AND `t`.`unlock_time` <= IF(`t`.`height` < %4q, %5q, %6q)))
+       ORDER BY `t`.`id`, `o`.`id`, `i`.`id`
+    )";
+
+    using UnlockedOutputs::UnlockedOutputs;
+
+    string table_name() const override { return this->table();};
+
+    json to_json() const override;
+
+};
+
+// not a table. outputs of an account, as needed by TxSearch to
+// find its inputs. out_pub_key is raw 32 bytes, not hex, so its
+// read from OutputsBin as it is with binary keys
+sql_create_4(KnownOutputs, 1, 0,
+             sql_varchar             , out_pub_key,
+             sql_bigint_unsigned     , amount,
+             sql_bigint_unsigned     , global_index,
+             sql_bool                , is_rct);
+
+
+struct XmrKnownOutput : public KnownOutputs, Table
+{
+
+    static constexpr const char* SELECT_STMT = R"(
+       SELECT UNHEX(`o`.`out_pub_key`) AS `out_pub_key`,
+              `o`.`amount`, `o`.`global_index`, `t`.`is_rct`
+       FROM `Outputs` AS `o`
+       INNER JOIN `Transactions` AS `t` ON `t`.`id` = `o`.`tx_id`
+       WHERE `o`.`account_id` = (%0q)
+    )";
+
+    static constexpr const char* SELECT_BIN_STMT = R"(
+       SELECT `o`.`out_pub_key`,
+              `o`.`amount`, `o`.`global_index`, `t`.`is_rct`
+       FROM `OutputsBin` AS `o`
+       INNER JOIN `TransactionsBin` AS `t` ON `t`.`id` = `o`.`tx_id`
+       WHERE `o`.`account_id` = (%0q)
+    )";
+
+    using KnownOutputs::KnownOutputs;
+
+    string table_name() const override { return this->table();};
+
+    json to_json() const override;
+
+};
+
 sql_create_9(Payments, 1, 7,
              sql_bigint_unsigned_null, id,
              sql_bigint_unsigned     , account_id,
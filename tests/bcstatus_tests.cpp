@@ -2,6 +2,7 @@
 #include "src/MicroCore.h"
 #include "../src/CurrentBlockchainStatus.h"
 #include "../src/ThreadRAII.h"
+#include "../src/OpenMoneroRequests.h"
 
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
@@ -9,6 +10,8 @@
 #include "helpers.h"
 #include "mocks.h"
 
+#include <set>
+
 namespace
 {
 
@@ -44,7 +47,7 @@ protected:
         tp = std::make_unique<TP::ThreadPool>();
         tp_ptr = tp.get();
 
-        bcs = std::make_unique<xmreg::CurrentBlockchainStatus>(
+        bcs = std::make_unique<MockTxpoolCurrentBlockchainStatus>(
                     bc_setup, std::move(mcore), std::move(rpc),
                     std::move(tp));
     }
@@ -55,7 +58,7 @@ protected:
      std::unique_ptr<MockMicroCore> mcore;
      std::unique_ptr<MockRPCCalls> rpc;
      std::unique_ptr<TP::ThreadPool> tp;
-     std::unique_ptr<xmreg::CurrentBlockchainStatus> bcs;
+     std::unique_ptr<MockTxpoolCurrentBlockchainStatus> bcs;
 
      MockMicroCore* mcore_ptr;
      MockRPCCalls* rpc_ptr;
@@ -120,11 +123,36 @@ TEST_P(BCSTATUS_TEST, GetBlockRange)
     EXPECT_CALL(*mcore_ptr, get_blocks_range(_, _))
             .WillOnce(ThrowBlockDNE());
 
-    blocks = bcs->get_blocks_range(h1, h2);
+    // different range, as the above blocks are in the block cache now
+    blocks = bcs->get_blocks_range(h1 + 10, h2 + 10);
 
     EXPECT_TRUE(blocks.empty());
 }
 
+TEST_P(BCSTATUS_TEST, GetBlockRangeFromCache)
+{
+   vector<block> blocks_to_return {block(), block(), block()};
+
+   // second call should not read blocks from lmdb
+   EXPECT_CALL(*mcore_ptr, get_blocks_range(_, _))
+           .WillOnce(Return(blocks_to_return));
+
+    uint64_t h1 = 1000;
+    uint64_t h2 = h1+2;
+
+    vector<block> blocks = bcs->get_blocks_range(h1, h2);
+
+    EXPECT_EQ(blocks, blocks_to_return);
+
+    blocks = bcs->get_blocks_range(h1, h2);
+
+    EXPECT_EQ(blocks, blocks_to_return);
+
+    block blk;
+
+    EXPECT_TRUE(bcs->get_block(h1 + 1, blk));
+}
+
 TEST_P(BCSTATUS_TEST, GetBlockTxs)
 {
     EXPECT_CALL(*mcore_ptr, get_transactions(_, _, _))
@@ -432,6 +460,50 @@ TEST_P(BCSTATUS_TEST, IsTxSpendtimeUnlockedScenario2)
 
 }
 
+TEST_P(BCSTATUS_TEST, GetUnlockLimits)
+{
+    const uint64_t mock_current_height {100};
+
+    EXPECT_CALL(*rpc_ptr, get_current_height(_))
+            .WillOnce(SetArgReferee<0>(mock_current_height));
+
+    bcs->update_current_blockchain_height();
+
+    MockTxUnlockChecker mock_tx_unlock_checker;
+
+    const uint64_t current_timestamp {1000000000};
+
+    EXPECT_CALL(mock_tx_unlock_checker, get_current_time())
+            .WillRepeatedly(Return(current_timestamp));
+
+    xmreg::UnlockLimits limits
+            = bcs->get_unlock_limits(mock_tx_unlock_checker);
+
+    // limits must agree with is_tx_unlocked, as they
+    // are used to filter unlocked outputs in mysql
+
+    uint64_t block_height {mock_current_height};
+
+    EXPECT_TRUE(bcs->is_tx_unlocked(limits.max_unlock_height,
+                                    block_height,
+                                    mock_tx_unlock_checker));
+
+    EXPECT_FALSE(bcs->is_tx_unlocked(limits.max_unlock_height + 1,
+                                     block_height,
+                                     mock_tx_unlock_checker));
+
+    uint64_t max_unlock_time = block_height < limits.v2height
+            ? limits.max_unlock_time_v1 : limits.max_unlock_time_v2;
+
+    EXPECT_TRUE(bcs->is_tx_unlocked(max_unlock_time,
+                                    block_height,
+                                    mock_tx_unlock_checker));
+
+    EXPECT_FALSE(bcs->is_tx_unlocked(max_unlock_time + 1,
+                                     block_height,
+                                     mock_tx_unlock_checker));
+}
+
 
 TEST_P(BCSTATUS_TEST, GetOutputKeys)
 {
@@ -648,16 +720,9 @@ TEST_P(BCSTATUS_TEST, ReadMempool)
 
     ASSERT_TRUE(xmreg::hex_to_tx_blob(tx_4b40_hex, tx_blob));
 
-    vector<tx_info> mempool_txs_to_return;
-
-    mempool_txs_to_return.push_back(tx_info{});
-
-    mempool_txs_to_return.back().tx_blob = tx_blob;
+    bcs->set_txpool({tx_blob});
 
-    EXPECT_CALL(*mcore_ptr, get_mempool_txs(_, _))
-            .WillOnce(DoAll(
-                          SetArgReferee<0>(mempool_txs_to_return),
-                          Return(true)));
+    EXPECT_CALL(*bcs, get_txpool_hashes(_)).Times(1);
 
     EXPECT_TRUE(bcs->read_mempool());
 
@@ -674,23 +739,17 @@ TEST_P(BCSTATUS_TEST, ReadMempool)
 
 TEST_P(BCSTATUS_TEST, ReadMempoolFailure)
 {
-    vector<tx_info> mempool_txs_to_return;
+    // txs which cant be parsed are skipped
+    bcs->set_txpool({"bad blob 1", "bad blob 2", "bad blob 3"});
 
-    mempool_txs_to_return.push_back(tx_info{});
-    mempool_txs_to_return.push_back(tx_info{});
-    mempool_txs_to_return.push_back(tx_info{});
+    EXPECT_CALL(*bcs, get_txpool_hashes(_)).Times(1);
 
-    EXPECT_CALL(*mcore_ptr, get_mempool_txs(_, _))
-            .WillOnce(DoAll(
-                          SetArgReferee<0>(mempool_txs_to_return),
-                          Return(true)));
+    EXPECT_TRUE(bcs->read_mempool());
 
-    EXPECT_FALSE(bcs->read_mempool());
+    EXPECT_TRUE(bcs->get_mempool_txs().empty());
 
-    EXPECT_CALL(*mcore_ptr, get_mempool_txs(_, _))
-            .WillOnce(DoAll(
-                          SetArgReferee<0>(mempool_txs_to_return),
-                          Return(false)));
+    EXPECT_CALL(*bcs, get_txpool_hashes(_))
+            .WillOnce(Return(false));
 
     EXPECT_FALSE(bcs->read_mempool());
 }
@@ -706,8 +765,6 @@ TEST_P(BCSTATUS_TEST, SearchIfPaymentMade)
         return;
     }
 
-    vector<tx_info> mempool_txs_to_return;
-
     vector<string> txs_hex;
 
     string expected_payment_id_str;
@@ -770,17 +827,9 @@ TEST_P(BCSTATUS_TEST, SearchIfPaymentMade)
         txs_blobs.push_back(tx_blob);
     }
 
-    for (auto const& tx_blob: txs_blobs)
-    {
-        mempool_txs_to_return.emplace_back();
-        mempool_txs_to_return.back().tx_blob = tx_blob;
-    }
-
+    bcs->set_txpool(txs_blobs);
 
-    EXPECT_CALL(*mcore_ptr, get_mempool_txs(_, _))
-            .WillOnce(DoAll(
-                          SetArgReferee<0>(mempool_txs_to_return),
-                          Return(true)));
+    EXPECT_CALL(*bcs, get_txpool_hashes(_)).Times(1);
 
     block mock_blk; // just an empty block
 
@@ -856,20 +905,12 @@ TEST_P(BCSTATUS_TEST, GetOutputKey)
     EXPECT_EQ(result.pubkey, output_to_return.pubkey);
 }
 
-ACTION(MockSearchWhile)
-{
-    cout << "\nMocking while search in txsearch class\n" << endl;
-}
-
 TEST_P(BCSTATUS_TEST, StartTxSearchThread)
 {
     xmreg::XmrAccount acc; // empty, mock account
 
     auto tx_search = std::make_unique<MockTxSearch>();
 
-    EXPECT_CALL(*tx_search, operator_fcall()) // mock operator()
-            .WillOnce(MockSearchWhile());
-
     EXPECT_CALL(*tx_search, get_exception_ptr())
             .WillOnce(Return(nullptr));
 
@@ -898,15 +939,8 @@ TEST_P(BCSTATUS_TEST, StartTxSearchThread)
     EXPECT_CALL(*tx_search3, get_exception_ptr())
             .WillOnce(Return(expt_ptr));
 
-    EXPECT_CALL(*tx_search3, operator_fcall()) // mock operator()
-            .WillOnce(MockSearchWhile());
-
     EXPECT_TRUE(bcs->start_tx_search_thread(acc2, std::move(tx_search3)));
 
-    // wait a bit, just to give time to tx_search mock thread to finish
-    // its mocking action
-    std::this_thread::sleep_for(1s);
-
     // cleaning up the search threads should detect that one
     // thread has some exception
     bcs->clean_search_thread_map();
@@ -914,12 +948,6 @@ TEST_P(BCSTATUS_TEST, StartTxSearchThread)
     EXPECT_FALSE(bcs->search_thread_exist(acc2.address));
 }
 
-ACTION(MockSearchWhile2)
-{
-    cout << "\nMocking while search in txsearch class2\n" << endl;
-    std::this_thread::sleep_for(1s);
-}
-
 TEST_P(BCSTATUS_TEST, GetSearchthreadThrows)
 {
     // CurrentBlockchainStatus::get_search_thread will throw
@@ -936,9 +964,6 @@ TEST_P(BCSTATUS_TEST, PingSearchThread)
 
     auto tx_search = std::make_unique<MockTxSearch>();
 
-    EXPECT_CALL(*tx_search, operator_fcall()) // mock operator()
-            .WillOnce(MockSearchWhile2());
-
     EXPECT_CALL(*tx_search, ping()).WillOnce(Return());
 
     EXPECT_CALL(*tx_search, still_searching())
@@ -974,9 +999,6 @@ TEST_P(BCSTATUS_TEST, GetSearchedBlkOutputsAndAddrViewkey)
 
     auto tx_search = std::make_unique<MockTxSearch>();
 
-    EXPECT_CALL(*tx_search, operator_fcall()) // mock operator()
-            .WillOnce(MockSearchWhile2());
-
     EXPECT_CALL(*tx_search, get_searched_blk_no())
             .WillOnce(Return(123));
 
@@ -1070,9 +1092,6 @@ TEST_P(BCSTATUS_TEST, FindTxsInMempool)
     EXPECT_CALL(*tx_search, mock_find_txs_in_mempool(_,_))
             .WillRepeatedly(SetArgReferee<1>(txs_to_return_json_str));
 
-    EXPECT_CALL(*tx_search, operator_fcall()) // mock operator()
-            .WillRepeatedly(MockSearchWhile2());
-
     ASSERT_TRUE(bcs->start_tx_search_thread(acc, std::move(tx_search)));
 
     nlohmann::json txs;
@@ -1157,8 +1176,6 @@ get_mock_txs_as_str(bool as_blob = false)
 
 TEST_P(BCSTATUS_TEST, FindTxsInMempool2)
 {
-    vector<tx_info> mempool_txs_to_return;
-
     vector<string> txs_blobs = get_mock_txs_as_str(true);
 
     ASSERT_FALSE(txs_blobs.empty());
@@ -1170,16 +1187,7 @@ TEST_P(BCSTATUS_TEST, FindTxsInMempool2)
     ASSERT_TRUE(parse_and_validate_tx_from_blob(
                     txs_blobs.at(2), selected_tx, tx_hash, tx_prefix_hash));
 
-    for (auto const& tx_blob: txs_blobs)
-    {
-        mempool_txs_to_return.emplace_back();
-        mempool_txs_to_return.back().tx_blob = tx_blob;
-    }
-
-    EXPECT_CALL(*mcore_ptr, get_mempool_txs(_, _))
-            .WillRepeatedly(DoAll(
-                          SetArgReferee<0>(mempool_txs_to_return),
-                          Return(true)));
+    bcs->set_txpool(txs_blobs);
 
     ASSERT_TRUE(bcs->read_mempool());
 
@@ -1197,20 +1205,9 @@ TEST_P(BCSTATUS_TEST, FindTxsInMempool2)
 
 TEST_P(BCSTATUS_TEST, FindKeyImagesInMempool)
 {
-    vector<tx_info> mempool_txs_to_return;
-
     vector<string> txs_blobs = get_mock_txs_as_str(true);
 
-    for (auto const& tx_blob: txs_blobs)
-    {
-        mempool_txs_to_return.emplace_back();
-        mempool_txs_to_return.back().tx_blob = tx_blob;
-    }
-
-    EXPECT_CALL(*mcore_ptr, get_mempool_txs(_, _))
-            .WillRepeatedly(DoAll(
-                          SetArgReferee<0>(mempool_txs_to_return),
-                          Return(true)));
+    bcs->set_txpool(txs_blobs);
 
     ASSERT_TRUE(bcs->read_mempool());
 
@@ -1238,7 +1235,7 @@ TEST_P(BCSTATUS_TEST, FindKeyImagesInMempool)
     crypto::hash tx_prefix_hash;
 
     parse_and_validate_tx_from_blob(
-                mempool_txs_to_return[1].tx_blob,
+                txs_blobs[1],
                 tx, tx_hash, tx_prefix_hash);
 
     EXPECT_TRUE(bcs->find_key_images_in_mempool(tx));
@@ -1264,6 +1261,82 @@ TEST_P(BCSTATUS_TEST, FindKeyImagesInMempool)
     EXPECT_FALSE(bcs->find_key_images_in_mempool(key_images_to_find2));
 }
 
+TEST_P(BCSTATUS_TEST, ReadMempoolAddsRemovesAndReAddsTxs)
+{
+    vector<string> txs_blobs = get_mock_txs_as_str(true);
+
+    ASSERT_GE(txs_blobs.size(), 2);
+
+    string const& blob_a = txs_blobs.at(0);
+    string const& blob_b = txs_blobs.at(1);
+
+    crypto::hash hash_a = bcs->txpool_tx_hash(blob_a);
+    crypto::hash hash_b = bcs->txpool_tx_hash(blob_b);
+
+    using hashes_t = std::set<string>;
+
+    auto mempool_hashes = [this]()
+    {
+        hashes_t hashes;
+
+        for (auto const& mtx: bcs->get_mempool_txs())
+            hashes.insert(pod_to_hex(get_transaction_hash(mtx.second)));
+
+        return hashes;
+    };
+
+    string hash_a_str = pod_to_hex(hash_a);
+    string hash_b_str = pod_to_hex(hash_b);
+
+    // both txs are new, so both are read
+    bcs->set_txpool({blob_a, blob_b});
+
+    EXPECT_CALL(*bcs, get_txpool_tx_blob(hash_a, _)).Times(1);
+    EXPECT_CALL(*bcs, get_txpool_tx_blob(hash_b, _)).Times(1);
+
+    ASSERT_TRUE(bcs->read_mempool());
+
+    EXPECT_EQ(mempool_hashes(), (hashes_t {hash_a_str, hash_b_str}));
+
+    uint64_t version = bcs->get_mempool_version();
+
+    // nothing changed, so no tx is read again
+    ASSERT_TRUE(bcs->read_mempool());
+
+    EXPECT_EQ(bcs->get_mempool_version(), version);
+
+    ::testing::Mock::VerifyAndClearExpectations(bcs.get());
+
+    // tx a left the mempool
+    bcs->set_txpool({blob_b});
+
+    EXPECT_CALL(*bcs, get_txpool_tx_blob(_, _)).Times(0);
+
+    ASSERT_TRUE(bcs->read_mempool());
+
+    EXPECT_EQ(mempool_hashes(), hashes_t {hash_b_str});
+    EXPECT_GT(bcs->get_mempool_version(), version);
+
+    version = bcs->get_mempool_version();
+
+    ::testing::Mock::VerifyAndClearExpectations(bcs.get());
+
+    // tx a is back, so only it is read again
+    bcs->set_txpool({blob_b, blob_a});
+
+    EXPECT_CALL(*bcs, get_txpool_tx_blob(hash_a, _)).Times(1);
+    EXPECT_CALL(*bcs, get_txpool_tx_blob(hash_b, _)).Times(0);
+
+    ASSERT_TRUE(bcs->read_mempool());
+
+    EXPECT_EQ(mempool_hashes(), (hashes_t {hash_a_str, hash_b_str}));
+    EXPECT_GT(bcs->get_mempool_version(), version);
+
+    transaction tx;
+
+    EXPECT_TRUE(bcs->find_tx_in_mempool(hash_a, tx));
+}
+
 TEST_P(BCSTATUS_TEST, ConstructOutputRctField_RingCTTx)
 {
     // testnet tx_hash 4942dbb5421c8516c05473f3cf191f07e419109fbdaf22bfcc7f8e95a0e73bf2
@@ -1488,16 +1561,7 @@ TEST_P(BCSTATUS_TEST, MonitorBlockchain)
 
     ASSERT_TRUE(xmreg::hex_to_tx_blob(tx_4b40_hex, tx_blob));
 
-    vector<tx_info> mempool_txs_to_return;
-
-    mempool_txs_to_return.push_back(tx_info{});
-
-    mempool_txs_to_return.back().tx_blob = tx_blob;
-
-    EXPECT_CALL(*mcore_ptr, get_mempool_txs(_, _))
-            .WillRepeatedly(DoAll(
-                          SetArgReferee<0>(mempool_txs_to_return),
-                          Return(true)));
+    bcs->set_txpool({tx_blob});
 
     // set refresh rate to 1 second as we dont wont to wait long
     xmreg::BlockchainSetup bs = bcs->get_bc_setup();
@@ -1532,6 +1596,55 @@ TEST_P(BCSTATUS_TEST, MonitorBlockchain)
 }
 
 
+TEST_P(BCSTATUS_TEST, SinceCursorValidOnlyForSameChangesAndEpoch)
+{
+    using xmreg::OpenMoneroRequests;
+
+    uint64_t service_epoch = bcs->get_service_epoch();
+
+    EXPECT_GT(service_epoch, 0);
+
+    nlohmann::json j_since {{"tx_id"          , 10},
+                            {"mempool_version", 3},
+                            {"changes"        , 5},
+                            {"epoch"          , service_epoch}};
+
+    EXPECT_TRUE(OpenMoneroRequests::since_cursor_valid(
+                    j_since, 5, service_epoch));
+
+    // rows of the account were updated or
+    // deleted since the cursor was returned
+    EXPECT_FALSE(OpenMoneroRequests::since_cursor_valid(
+                    j_since, 6, service_epoch));
+
+    // service was restarted, so mempool_version
+    // could be the same, but not the epoch
+    std::this_thread::sleep_for(2ms);
+
+    xmreg::CurrentBlockchainStatus restarted_bcs {
+        bc_setup, nullptr, nullptr, nullptr};
+
+    EXPECT_NE(restarted_bcs.get_service_epoch(), service_epoch);
+
+    EXPECT_FALSE(OpenMoneroRequests::since_cursor_valid(
+                    j_since, 5, restarted_bcs.get_service_epoch()));
+
+    // cursors returned before changes and
+    // epoch were added to them
+    EXPECT_FALSE(OpenMoneroRequests::since_cursor_valid(
+                    nlohmann::json {{"tx_id", 10}, {"mempool_version", 3}},
+                    0, service_epoch));
+
+    EXPECT_FALSE(OpenMoneroRequests::since_cursor_valid(
+                    nlohmann::json {{"input_id", 10}, {"changes", "5"},
+                                    {"epoch", service_epoch}},
+                    5, service_epoch));
+
+    EXPECT_FALSE(OpenMoneroRequests::since_cursor_valid(
+                    nlohmann::json {}, 0, service_epoch));
+}
+
+
 INSTANTIATE_TEST_CASE_P(
         DifferentMoneroNetworks, BCSTATUS_TEST,
         ::testing::Values(
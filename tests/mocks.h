@@ -131,8 +131,8 @@ public:
 class MockTxSearch : public xmreg::TxSearch
 {
 public:
-    MOCK_METHOD0(operator_fcall, void());
-    virtual void operator()() {operator_fcall();}
+    MOCK_METHOD2(scan_window, void(xmreg::ScanWindow const& window,
+                                   xmreg::ScanWorkerPool* workers));
 
     MOCK_METHOD0(ping, void());
 
@@ -159,7 +159,7 @@ public:
     // to return j_transactions based on transactions_json_str
     // from the mock_find_txs_in_mempool
     virtual void
-    find_txs_in_mempool(pool_txs_t mempool_txs,
+    find_txs_in_mempool(pool_txs_t const& mempool_txs,
                         nlohmann::json* j_transactions)
     {
         vector<string> transactions_json_str;
@@ -173,6 +173,8 @@ public:
 
     MOCK_METHOD0(get_exception_ptr, std::exception_ptr());
 
+    MOCK_METHOD0(stop_if_not_pinged, void());
+
 };
 
 class MockCurrentBlockchainStatus : public xmreg::CurrentBlockchainStatus
@@ -187,6 +189,83 @@ public:
                  bool(const uint64_t& amount,
                       const vector<uint64_t>& absolute_offsets,
                       vector<cryptonote::output_data_t>& outputs));
+
+    // accounts and windows of BlockScanner
+    MOCK_METHOD0(get_search_threads,
+                 vector<shared_ptr<xmreg::TxSearch>>());
+
+    MOCK_METHOD2(get_scan_window,
+                 shared_ptr<xmreg::ScanWindow>(uint64_t h1, uint64_t h2));
+};
+
+
+// CurrentBlockchainStatus with mocked txpool of the daemon, as
+// MicroCore gives access to it only through its core. set_txpool
+// makes the txpool have the given txs
+class MockTxpoolCurrentBlockchainStatus
+        : public xmreg::CurrentBlockchainStatus
+{
+public:
+    using xmreg::CurrentBlockchainStatus::CurrentBlockchainStatus;
+
+    MOCK_METHOD1(get_txpool_hashes,
+                 bool(vector<pair<crypto::hash, uint64_t>>& pool_hashes));
+
+    MOCK_METHOD2(get_txpool_tx_blob,
+                 bool(crypto::hash const& tx_hash,
+                      cryptonote::blobdata& tx_blob));
+
+    // txs which cant be parsed get hash of their blob
+    static crypto::hash
+    txpool_tx_hash(string const& tx_blob)
+    {
+        transaction tx;
+        crypto::hash tx_hash;
+        crypto::hash tx_prefix_hash;
+
+        if (!parse_and_validate_tx_from_blob(tx_blob, tx, tx_hash,
+                                             tx_prefix_hash))
+            tx_hash = get_blob_hash(tx_blob);
+
+        return tx_hash;
+    }
+
+    void
+    set_txpool(vector<string> const& tx_blobs, uint64_t receive_time = 0)
+    {
+        auto txpool = make_shared<vector<pair<crypto::hash, string>>>();
+
+        for (auto const& tx_blob: tx_blobs)
+            txpool->emplace_back(txpool_tx_hash(tx_blob), tx_blob);
+
+        ON_CALL(*this, get_txpool_hashes(_))
+                .WillByDefault(Invoke(
+                    [txpool, receive_time](
+                        vector<pair<crypto::hash, uint64_t>>& pool_hashes)
+                    {
+                        pool_hashes.clear();
+
+                        for (auto const& tx: *txpool)
+                            pool_hashes.emplace_back(tx.first, receive_time);
+
+                        return true;
+                    }));
+
+        ON_CALL(*this, get_txpool_tx_blob(_, _))
+                .WillByDefault(Invoke(
+                    [txpool](crypto::hash const& tx_hash,
+                             cryptonote::blobdata& tx_blob)
+                    {
+                        for (auto const& tx: *txpool)
+                            if (tx.first == tx_hash)
+                            {
+                                tx_blob = tx.second;
+                                return true;
+                            }
+
+                        return false;
+                    }));
+    }
 };
 
 
@@ -5,6 +5,7 @@
 #include "src/MicroCore.h"
 #include "../src/OpenMoneroRequests.h"
 #include "../src/db/MysqlPing.h"
+#include "../src/DbWriter.h"
 
 //#include "chaingen.h"
 //#include "chaingen_tests_list.h"
@@ -582,6 +583,100 @@ TEST_F(MYSQL_TEST, DeleteNoNExistingTx)
     EXPECT_EQ(no_of_deleted_rows, 0);
 }
 
+// window of a single block of the existing tx, with
+// scanned_block_height of the account moved to it
+xmreg::WindowWrite
+window_of_tx_block(xmreg::XmrAccount const& acc,
+                   xmreg::XmrTransaction const& tx_data)
+{
+    xmreg::WindowWrite window;
+
+    window.account_id  = acc.id.data;
+    window.h1          = tx_data.height;
+    window.h2          = tx_data.height;
+    window.acc         = acc;
+    window.updated_acc = acc;
+    window.updated_acc.scanned_block_height = tx_data.height;
+
+    return window;
+}
+
+TEST_F(MYSQL_TEST, WriteWindowKeepsTxsWhichAreNotFoundAgain)
+{
+    // rescanned window, in which other tx than
+    // the existing one was found
+    TX_AND_ACC_FROM_HEX(tx_fc4_hex, owner_addr_5Ajfk);
+
+    xmreg::XmrTransaction tx_data;
+
+    ASSERT_TRUE(xmr_accounts->tx_exists(acc.id.data, tx_hash_str, tx_data));
+
+    uint64_t changes_before {0};
+
+    ASSERT_TRUE(xmr_accounts->get_changes(acc.id.data, changes_before));
+
+    xmreg::XmrTransaction new_tx = tx_data;
+
+    new_tx.id   = mysqlpp::null;
+    new_tx.hash = pod_to_hex(crypto::rand<crypto::hash>());
+
+    xmreg::WindowWrite window = window_of_tx_block(acc, tx_data);
+
+    window.txs.push_back(new_tx);
+
+    xmreg::DbWriter::write_window(*xmr_accounts, window, nullptr);
+
+    EXPECT_TRUE(window.acc_updated);
+
+    // rows are only upserted, so the tx
+    // is still there with the same id
+    xmreg::XmrTransaction tx_in_mysql;
+
+    ASSERT_TRUE(xmr_accounts->tx_exists(acc.id.data, tx_hash_str,
+                                        tx_in_mysql));
+    EXPECT_EQ(tx_in_mysql.id.data, tx_data.id.data);
+
+    EXPECT_TRUE(xmr_accounts->tx_exists(acc.id.data, new_tx.hash,
+                                        tx_in_mysql));
+
+    // new tx was only inserted, which is not a change of the account
+    uint64_t changes_after {0};
+
+    ASSERT_TRUE(xmr_accounts->get_changes(acc.id.data, changes_after));
+    EXPECT_EQ(changes_after, changes_before);
+}
+
+TEST_F(MYSQL_TEST, WriteWindowWithoutTxsKeepsTxsOfItsBlocks)
+{
+    // rescanned window, in which nothing was found
+    TX_AND_ACC_FROM_HEX(tx_fc4_hex, owner_addr_5Ajfk);
+
+    xmreg::XmrTransaction tx_data;
+
+    ASSERT_TRUE(xmr_accounts->tx_exists(acc.id.data, tx_hash_str, tx_data));
+
+    uint64_t changes_before {0};
+
+    ASSERT_TRUE(xmr_accounts->get_changes(acc.id.data, changes_before));
+
+    xmreg::WindowWrite window = window_of_tx_block(acc, tx_data);
+
+    xmreg::DbWriter::write_window(*xmr_accounts, window, nullptr);
+
+    EXPECT_TRUE(window.acc_updated);
+
+    xmreg::XmrTransaction tx_in_mysql;
+
+    ASSERT_TRUE(xmr_accounts->tx_exists(acc.id.data, tx_hash_str,
+                                        tx_in_mysql));
+    EXPECT_EQ(tx_in_mysql.id.data, tx_data.id.data);
+
+    uint64_t changes_after {0};
+
+    ASSERT_TRUE(xmr_accounts->get_changes(acc.id.data, changes_after));
+    EXPECT_EQ(changes_after, changes_before);
+}
+
 
 TEST_F(MYSQL_TEST, MarkTxSpendableAndNonSpendable)
 {
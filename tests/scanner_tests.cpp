@@ -0,0 +1,1125 @@
+//
+// unit tests of scanning building blocks which
+// dont need blockchain nor mysql
+//
+
+#include "src/ScanWorkerPool.h"
+#include "src/BlockCache.h"
+#include "src/ScanDigest.h"
+#include "src/RingMemberIndex.h"
+#include "src/DbWriter.h"
+#include "src/BlockScanner.h"
+#include "../src/TxSearch.h"
+
+#include "mocks.h"
+#include "JsonTx.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+#include <atomic>
+#include <vector>
+#include <thread>
+#include <stdexcept>
+
+
+namespace
+{
+
+using namespace std;
+using namespace cryptonote;
+using namespace std::chrono_literals;
+
+
+TEST(SCAN_WORKER_POOL, SubmittedTasksAreExecuted)
+{
+    std::atomic<size_t> no_of_executed {0};
+
+    {
+        xmreg::ScanWorkerPool pool {4};
+
+        EXPECT_EQ(pool.size(), 4);
+
+        for (size_t i = 0; i < 1000; ++i)
+            pool.submit([&no_of_executed]() {++no_of_executed;});
+
+        // destructor finishes all queued tasks
+    }
+
+    EXPECT_EQ(no_of_executed, 1000);
+}
+
+TEST(SCAN_WORKER_POOL, TaskGroupWaitsForItsTasks)
+{
+    xmreg::ScanWorkerPool pool {3};
+
+    auto group = make_shared<xmreg::ScanTaskGroup>();
+
+    std::atomic<size_t> no_of_executed {0};
+
+    for (size_t i = 0; i < 100; ++i)
+        pool.submit([&no_of_executed]()
+        {
+            std::this_thread::sleep_for(std::chrono::microseconds(100));
+            ++no_of_executed;
+        }, group);
+
+    group->wait();
+
+    EXPECT_TRUE(group->finished());
+    EXPECT_EQ(no_of_executed, 100);
+}
+
+TEST(SCAN_WORKER_POOL, TaskGroupCountsThrowingTasks)
+{
+    xmreg::ScanWorkerPool pool {2};
+
+    auto group = make_shared<xmreg::ScanTaskGroup>();
+
+    for (size_t i = 0; i < 10; ++i)
+        pool.submit([]() {throw std::runtime_error("task failed");},
+                    group);
+
+    group->wait();
+
+    EXPECT_TRUE(group->finished());
+}
+
+TEST(SCAN_WORKER_POOL, ParallelForCallsEachIndexOnce)
+{
+    xmreg::ScanWorkerPool pool {4};
+
+    vector<std::atomic<size_t>> calls(500);
+
+    pool.parallel_for(calls.size(), [&calls](size_t i) {++calls[i];});
+
+    for (auto const& no_of_calls: calls)
+        EXPECT_EQ(no_of_calls, 1);
+}
+
+TEST(SCAN_WORKER_POOL, ParallelForRethrowsException)
+{
+    xmreg::ScanWorkerPool pool {4};
+
+    std::atomic<size_t> no_of_calls {0};
+
+    EXPECT_THROW(pool.parallel_for(100, [&no_of_calls](size_t i)
+                 {
+                     ++no_of_calls;
+
+                     if (i == 42)
+                         throw std::runtime_error("index 42 failed");
+                 }),
+                 std::runtime_error);
+
+    // all indices are still processed
+    EXPECT_EQ(no_of_calls, 100);
+}
+
+TEST(SCAN_WORKER_POOL, ParallelForFromWithinTask)
+{
+    xmreg::ScanWorkerPool pool {2};
+
+    auto group = make_shared<xmreg::ScanTaskGroup>();
+
+    std::atomic<size_t> no_of_calls {0};
+
+    // all workers busy with parallel_for of their own
+    // must not deadlock
+    for (size_t i = 0; i < 4; ++i)
+        pool.submit([&pool, &no_of_calls]()
+        {
+            pool.parallel_for(50, [&no_of_calls](size_t)
+                              {++no_of_calls;});
+        }, group);
+
+    group->wait();
+
+    EXPECT_EQ(no_of_calls, 200);
+}
+
+// blocks which differ only by nonce are enough to
+// tell the cache they are different blocks
+block
+make_block(uint64_t height, uint32_t nonce = 0)
+{
+    block blk {};
+
+    blk.timestamp = 1000 + height;
+    blk.nonce = nonce;
+
+    return blk;
+}
+
+TEST(BLOCK_CACHE, PutAndGetBlocks)
+{
+    xmreg::BlockCache cache {10};
+
+    for (uint64_t h = 100; h < 105; ++h)
+        cache.put_block(h, make_block(h));
+
+    EXPECT_EQ(cache.size(), 5);
+
+    block blk;
+
+    ASSERT_TRUE(cache.get_block(102, blk));
+    EXPECT_EQ(blk.timestamp, 1102);
+
+    EXPECT_FALSE(cache.get_block(105, blk));
+
+    vector<block> blocks;
+
+    ASSERT_TRUE(cache.get_blocks(100, 104, blocks));
+    EXPECT_EQ(blocks.size(), 5);
+
+    // whole range must be cached
+    EXPECT_FALSE(cache.get_blocks(103, 105, blocks));
+}
+
+TEST(BLOCK_CACHE, EvictsLeastRecentlyUsed)
+{
+    xmreg::BlockCache cache {3};
+
+    cache.put_block(1, make_block(1));
+    cache.put_block(2, make_block(2));
+    cache.put_block(3, make_block(3));
+
+    block blk;
+
+    // makes block 1 most recently used
+    ASSERT_TRUE(cache.get_block(1, blk));
+
+    cache.put_block(4, make_block(4));
+
+    EXPECT_EQ(cache.size(), 3);
+    EXPECT_TRUE(cache.get_block(1, blk));
+    EXPECT_FALSE(cache.get_block(2, blk));
+    EXPECT_TRUE(cache.get_block(4, blk));
+}
+
+TEST(BLOCK_CACHE, ZeroSizeDisablesCache)
+{
+    xmreg::BlockCache cache {0};
+
+    cache.put_block(1, make_block(1));
+
+    block blk;
+
+    EXPECT_EQ(cache.size(), 0);
+    EXPECT_FALSE(cache.get_block(1, blk));
+}
+
+TEST(BLOCK_CACHE, InvalidateFromRemovesBlocksAndTxs)
+{
+    xmreg::BlockCache cache {10};
+
+    crypto::hash tx_hash = crypto::rand<crypto::hash>();
+
+    for (uint64_t h = 10; h < 15; ++h)
+        cache.put_block(h, make_block(h));
+
+    cache.put_block_txs(13, make_block(13), {tx_hash}, {transaction {}});
+
+    transaction tx;
+
+    ASSERT_TRUE(cache.get_tx(tx_hash, tx));
+
+    cache.invalidate_from(12);
+
+    EXPECT_EQ(cache.size(), 2);
+    EXPECT_EQ(cache.get_top_heights(10), (vector<uint64_t> {11, 10}));
+    EXPECT_FALSE(cache.get_tx(tx_hash, tx));
+}
+
+TEST(BLOCK_CACHE, DifferentBlockAtSameHeightInvalidatesAbove)
+{
+    xmreg::BlockCache cache {10};
+
+    crypto::hash tx_hash = crypto::rand<crypto::hash>();
+
+    for (uint64_t h = 10; h < 15; ++h)
+        cache.put_block(h, make_block(h));
+
+    cache.put_block_txs(14, make_block(14), {tx_hash}, {transaction {}});
+
+    crypto::hash old_hash;
+
+    ASSERT_TRUE(cache.get_block_hash(12, old_hash));
+
+    // putting the same block again changes nothing
+    cache.put_block(12, make_block(12));
+
+    EXPECT_EQ(cache.size(), 5);
+
+    // alternative block at height 12 from a reorg
+    cache.put_block(12, make_block(12, 1));
+
+    EXPECT_EQ(cache.size(), 3);
+
+    crypto::hash new_hash;
+
+    ASSERT_TRUE(cache.get_block_hash(12, new_hash));
+    EXPECT_NE(old_hash, new_hash);
+
+    block blk;
+    transaction tx;
+
+    EXPECT_FALSE(cache.get_block(13, blk));
+    EXPECT_FALSE(cache.get_block(14, blk));
+    EXPECT_FALSE(cache.get_tx(tx_hash, tx));
+}
+
+// digest in its own temporary folder, removed
+// when the test finishes
+class SCAN_DIGEST : public ::testing::Test
+{
+protected:
+
+    void
+    SetUp() override
+    {
+        digest_dir = boost::filesystem::temp_directory_path()
+                / boost::filesystem::unique_path("scan_digest_%%%%%%%%");
+    }
+
+    void
+    TearDown() override
+    {
+        boost::system::error_code ec;
+        boost::filesystem::remove_all(digest_dir, ec);
+    }
+
+    boost::filesystem::path digest_dir;
+};
+
+TEST_F(SCAN_DIGEST, WriteAndReadTxs)
+{
+    vector<string> tx_hashes_str {
+        "d7dcb2daa64b5718dad71778112d48ad62f4d5f54337037c420cb76efdd8a21c",
+        "ddff95211b53c194a16c2b8f37ae44b643b8bd46b4cb402af961ecabeb8417b2",
+        "f3c84fe925292ec5b4dc383d306d934214f4819611566051bca904d1cf4efceb"};
+
+    vector<crypto::hash> txs_hashes;
+    vector<transaction> txs;
+    vector<crypto::hash> prefix_hashes;
+
+    for (auto const& tx_hash_str: tx_hashes_str)
+    {
+        auto jtx = xmreg::construct_jsontx(tx_hash_str);
+
+        ASSERT_TRUE(jtx);
+
+        txs_hashes.push_back(jtx->tx_hash);
+        txs.push_back(jtx->tx);
+        prefix_hashes.push_back(jtx->tx_prefix_hash);
+    }
+
+    xmreg::ScanDigest digest {digest_dir.string()};
+
+    ASSERT_TRUE(digest.open());
+    EXPECT_EQ(digest.get_height(), 0);
+
+    crypto::hash blk_hash = crypto::rand<crypto::hash>();
+
+    // blocks must be added in order
+    EXPECT_FALSE(digest.add_block(1, blk_hash, 1000,
+                                  txs_hashes, txs));
+
+    ASSERT_TRUE(digest.add_block(0, blk_hash, 1000,
+                                 txs_hashes, txs));
+    ASSERT_TRUE(digest.add_block(1, crypto::rand<crypto::hash>(), 1001,
+                                 {txs_hashes[0]}, {txs[0]}));
+
+    EXPECT_EQ(digest.get_height(), 2);
+
+    crypto::hash read_blk_hash;
+
+    ASSERT_TRUE(digest.get_block_hash(0, read_blk_hash));
+    EXPECT_EQ(read_blk_hash, blk_hash);
+
+    xmreg::ScanWindow window;
+
+    ASSERT_TRUE(digest.get_window(0, 1, window));
+
+    EXPECT_EQ(window.h1, 0);
+    EXPECT_EQ(window.h2, 1);
+    EXPECT_EQ(window.last_block_timestamp, 1001);
+
+    ASSERT_EQ(window.txs.size(), txs.size() + 1);
+    ASSERT_EQ(window.txs_data.size(), txs.size() + 1);
+
+    for (size_t i = 0; i < txs.size(); ++i)
+    {
+        transaction const& tx = txs[i];
+        transaction const& read_tx = window.txs[i];
+
+        EXPECT_EQ(window.txs_hashes[i], txs_hashes[i]);
+
+        // everything in tx prefix is kept
+        EXPECT_EQ(get_transaction_prefix_hash(read_tx), prefix_hashes[i]);
+
+        EXPECT_EQ(read_tx.vin.size(), tx.vin.size());
+        EXPECT_EQ(read_tx.vout.size(), tx.vout.size());
+
+        EXPECT_EQ(read_tx.rct_signatures.type, tx.rct_signatures.type);
+        EXPECT_EQ(read_tx.rct_signatures.txnFee, tx.rct_signatures.txnFee);
+
+        ASSERT_EQ(read_tx.rct_signatures.ecdhInfo.size(),
+                  tx.rct_signatures.ecdhInfo.size());
+
+        for (size_t j = 0; j < tx.rct_signatures.ecdhInfo.size(); ++j)
+            EXPECT_EQ(read_tx.rct_signatures.ecdhInfo[j].amount,
+                      tx.rct_signatures.ecdhInfo[j].amount);
+
+        ASSERT_EQ(read_tx.rct_signatures.outPk.size(),
+                  tx.rct_signatures.outPk.size());
+
+        for (size_t j = 0; j < tx.rct_signatures.outPk.size(); ++j)
+            EXPECT_EQ(read_tx.rct_signatures.outPk[j].mask,
+                      tx.rct_signatures.outPk[j].mask);
+
+        EXPECT_EQ(std::get<0>(window.txs_data[i]), 0);
+        EXPECT_EQ(std::get<1>(window.txs_data[i]), 1000);
+        EXPECT_EQ(std::get<2>(window.txs_data[i]), i == 0);
+    }
+
+    EXPECT_EQ(window.txs_hashes.back(), txs_hashes[0]);
+    EXPECT_EQ(std::get<0>(window.txs_data.back()), 1);
+
+    // blocks above the digest are not there
+    EXPECT_FALSE(digest.get_window(1, 2, window));
+}
+
+TEST_F(SCAN_DIGEST, PopBlocksAndReopen)
+{
+    auto jtx = xmreg::construct_jsontx(
+            "ddff95211b53c194a16c2b8f37ae44b643b8bd46b4cb402af961ecabeb8417b2");
+
+    ASSERT_TRUE(jtx);
+
+    {
+        xmreg::ScanDigest digest {digest_dir.string()};
+
+        ASSERT_TRUE(digest.open());
+
+        for (uint64_t h = 0; h < 5; ++h)
+            ASSERT_TRUE(digest.add_block(h, crypto::rand<crypto::hash>(),
+                                         1000 + h,
+                                         {jtx->tx_hash}, {jtx->tx}));
+
+        // reorg
+        digest.pop_blocks(3);
+
+        EXPECT_EQ(digest.get_height(), 3);
+
+        ASSERT_TRUE(digest.add_block(3, crypto::rand<crypto::hash>(),
+                                     2003, {jtx->tx_hash}, {jtx->tx}));
+
+        digest.flush();
+    }
+
+    xmreg::ScanDigest digest {digest_dir.string()};
+
+    ASSERT_TRUE(digest.open());
+    EXPECT_EQ(digest.get_height(), 4);
+
+    xmreg::ScanWindow window;
+
+    ASSERT_TRUE(digest.get_window(2, 3, window));
+
+    EXPECT_EQ(window.last_block_timestamp, 2003);
+    ASSERT_EQ(window.txs_hashes.size(), 2);
+    EXPECT_EQ(window.txs_hashes[1], jtx->tx_hash);
+}
+
+
+// index in its own temporary folder, same as
+// in SCAN_DIGEST
+class RING_MEMBER_INDEX : public ::testing::Test
+{
+protected:
+
+    void
+    SetUp() override
+    {
+        index_dir = boost::filesystem::temp_directory_path()
+                / boost::filesystem::unique_path("ring_index_%%%%%%%%");
+    }
+
+    void
+    TearDown() override
+    {
+        boost::system::error_code ec;
+        boost::filesystem::remove_all(index_dir, ec);
+    }
+
+    // tx with one input having the given
+    // global indices as its ring members
+    static transaction
+    make_ring_tx(uint64_t amount, vector<uint64_t> const& global_indices)
+    {
+        txin_to_key in;
+
+        in.amount = amount;
+        in.key_offsets = absolute_output_offsets_to_relative(
+                    global_indices);
+
+        transaction tx;
+        tx.vin.push_back(in);
+
+        return tx;
+    }
+
+    boost::filesystem::path index_dir;
+};
+
+TEST_F(RING_MEMBER_INDEX, AddBlocksAndFind)
+{
+    xmreg::RingMemberIndex index {index_dir.string()};
+
+    ASSERT_TRUE(index.open());
+    EXPECT_EQ(index.get_indexed_height(), 0);
+
+    crypto::hash blk_hash = crypto::rand<crypto::hash>();
+
+    // blocks must be added in order
+    EXPECT_FALSE(index.add_block(1, blk_hash, {make_ring_tx(0, {8})}));
+
+    ASSERT_TRUE(index.add_block(0, blk_hash,
+                                {make_ring_tx(0, {5, 8, 10}),
+                                 make_ring_tx(1000, {8})}));
+
+    // coinbase inputs have no ring members
+    txin_gen gen;
+    gen.height = 1;
+
+    transaction coinbase_tx;
+    coinbase_tx.vin.push_back(gen);
+
+    ASSERT_TRUE(index.add_block(1, crypto::rand<crypto::hash>(),
+                                {coinbase_tx, make_ring_tx(0, {8, 20})}));
+
+    EXPECT_EQ(index.get_indexed_height(), 2);
+
+    crypto::hash read_blk_hash;
+
+    ASSERT_TRUE(index.get_block_hash(0, read_blk_hash));
+    EXPECT_EQ(read_blk_hash, blk_hash);
+
+    EXPECT_FALSE(index.get_block_hash(2, read_blk_hash));
+
+    // from the highest block down
+    EXPECT_EQ(index.find(0, 8), (vector<uint64_t> {1, 0}));
+    EXPECT_EQ(index.find(0, 8, 1), (vector<uint64_t> {1}));
+    EXPECT_EQ(index.find(0, 5), (vector<uint64_t> {0}));
+    EXPECT_EQ(index.find(0, 20), (vector<uint64_t> {1}));
+
+    // pre-ringct outputs are separate from ringct ones
+    EXPECT_EQ(index.find(1000, 8), (vector<uint64_t> {0}));
+    EXPECT_TRUE(index.find(1000, 5).empty());
+
+    EXPECT_TRUE(index.find(0, 9).empty());
+}
+
+TEST_F(RING_MEMBER_INDEX, PopBlocksAndReopen)
+{
+    vector<crypto::hash> blk_hashes;
+
+    {
+        xmreg::RingMemberIndex index {index_dir.string()};
+
+        ASSERT_TRUE(index.open());
+
+        for (uint64_t h = 0; h < 5; ++h)
+        {
+            blk_hashes.push_back(crypto::rand<crypto::hash>());
+
+            ASSERT_TRUE(index.add_block(h, blk_hashes.back(),
+                                        {make_ring_tx(0, {h, 100})}));
+        }
+
+        // reorg
+        index.pop_blocks(3);
+
+        EXPECT_EQ(index.get_indexed_height(), 3);
+        EXPECT_EQ(index.get_no_of_pops(), 1);
+
+        EXPECT_EQ(index.find(0, 100), (vector<uint64_t> {2, 1, 0}));
+        EXPECT_TRUE(index.find(0, 3).empty());
+        EXPECT_TRUE(index.find(0, 4).empty());
+
+        blk_hashes.resize(3);
+        blk_hashes.push_back(crypto::rand<crypto::hash>());
+
+        ASSERT_TRUE(index.add_block(3, blk_hashes.back(),
+                                    {make_ring_tx(0, {100, 200})}));
+
+        index.flush();
+    }
+
+    xmreg::RingMemberIndex index {index_dir.string()};
+
+    ASSERT_TRUE(index.open());
+    EXPECT_EQ(index.get_indexed_height(), 4);
+
+    for (uint64_t h = 0; h < 4; ++h)
+    {
+        crypto::hash read_blk_hash;
+
+        ASSERT_TRUE(index.get_block_hash(h, read_blk_hash));
+        EXPECT_EQ(read_blk_hash, blk_hashes[h]);
+    }
+
+    EXPECT_EQ(index.find(0, 100), (vector<uint64_t> {3, 2, 1, 0}));
+    EXPECT_EQ(index.find(0, 200), (vector<uint64_t> {3}));
+    EXPECT_TRUE(index.find(0, 3).empty());
+}
+
+TEST_F(RING_MEMBER_INDEX, HeadsAreRehashedWhenFull)
+{
+    // more outputs than fit into the initial heads
+    // table of 1 << 16 buckets at 0.7 load factor
+    uint64_t const no_of_outputs {60000};
+
+    vector<uint64_t> global_indices;
+
+    for (uint64_t i = 0; i < no_of_outputs; ++i)
+        global_indices.push_back(i);
+
+    {
+        xmreg::RingMemberIndex index {index_dir.string()};
+
+        ASSERT_TRUE(index.open());
+
+        ASSERT_TRUE(index.add_block(0, crypto::rand<crypto::hash>(),
+                                    {make_ring_tx(0, global_indices)}));
+
+        ASSERT_TRUE(index.add_block(1, crypto::rand<crypto::hash>(),
+                                    {make_ring_tx(0, {0, no_of_outputs - 1,
+                                                      no_of_outputs})}));
+
+        for (uint64_t i = 0; i < no_of_outputs; i += 997)
+            EXPECT_FALSE(index.find(0, i).empty()) << i;
+
+        EXPECT_EQ(index.find(0, 0), (vector<uint64_t> {1, 0}));
+        EXPECT_EQ(index.find(0, no_of_outputs - 1),
+                  (vector<uint64_t> {1, 0}));
+        EXPECT_EQ(index.find(0, no_of_outputs), (vector<uint64_t> {1}));
+
+        index.flush();
+    }
+
+    // heads are rebuilt from records if they are missing
+    boost::filesystem::remove(index_dir / "heads.bin");
+
+    xmreg::RingMemberIndex index {index_dir.string()};
+
+    ASSERT_TRUE(index.open());
+    EXPECT_EQ(index.get_indexed_height(), 2);
+
+    for (uint64_t i = 0; i < no_of_outputs; i += 997)
+        EXPECT_FALSE(index.find(0, i).empty()) << i;
+
+    EXPECT_EQ(index.find(0, 0), (vector<uint64_t> {1, 0}));
+    EXPECT_EQ(index.find(0, no_of_outputs), (vector<uint64_t> {1}));
+    EXPECT_TRUE(index.find(0, no_of_outputs + 1).empty());
+}
+
+
+// writer without mysql. commit of windows waits until open
+// is called, and fails if any window is of bad_account
+class TEST_DB_WRITER : public xmreg::DbWriter
+{
+public:
+
+    static constexpr uint64_t bad_account {666};
+
+    ~TEST_DB_WRITER()
+    {
+        open();
+        stop();
+    }
+
+    void
+    open()
+    {
+        {
+            std::lock_guard<std::mutex> lck (mtx);
+            is_open = true;
+        }
+
+        open_cv.notify_all();
+    }
+
+    // sizes of all commits, failed or not
+    vector<size_t>
+    get_commit_sizes()
+    {
+        std::lock_guard<std::mutex> lck (mtx);
+        return commit_sizes;
+    }
+
+    // waits until the writer thread is in commit_windows
+    // with the given number of commits, including ones
+    // waiting for open
+    void
+    wait_for_commits(size_t no_of_commits)
+    {
+        std::unique_lock<std::mutex> lck (mtx);
+
+        entered_cv.wait(lck, [this, no_of_commits]()
+                        {return no_of_entered >= no_of_commits;});
+    }
+
+    // waits until the given number of windows is queued
+    // for the next group
+    void
+    wait_for_queued(size_t no_of_queued)
+    {
+        while (queue_size() < no_of_queued)
+            std::this_thread::yield();
+    }
+
+protected:
+
+    void
+    commit_windows(vector<xmreg::WindowWrite*> const& windows) override
+    {
+        std::unique_lock<std::mutex> lck (mtx);
+
+        ++no_of_entered;
+        entered_cv.notify_all();
+
+        open_cv.wait(lck, [this]() {return is_open;});
+
+        commit_sizes.push_back(windows.size());
+
+        for (auto* window_write: windows)
+            if (window_write->account_id == bad_account)
+                throw xmreg::DbWriterException("bad window");
+
+        for (auto* window_write: windows)
+            window_write->acc_updated = true;
+    }
+
+private:
+
+    std::mutex mtx;
+    std::condition_variable open_cv;
+    std::condition_variable entered_cv;
+    bool is_open {false};
+    size_t no_of_entered {0};
+    vector<size_t> commit_sizes;
+};
+
+// writes window of the account in its own thread. result
+// is true if it was committed, and false if write threw
+std::thread
+write_window_of(TEST_DB_WRITER& writer, uint64_t account_id,
+                std::shared_ptr<xmreg::WindowWrite>& window_write,
+                std::atomic<int>& result)
+{
+    window_write = std::make_shared<xmreg::WindowWrite>();
+    window_write->account_id = account_id;
+
+    return std::thread([&writer, window_write, &result]()
+    {
+        try
+        {
+            writer.write(window_write);
+            result = 1;
+        }
+        catch (xmreg::DbWriterException const&)
+        {
+            result = 0;
+        }
+    });
+}
+
+TEST(DB_WRITER, FailedGroupIsWrittenOneByOne)
+{
+    TEST_DB_WRITER writer;
+
+    vector<uint64_t> account_ids {1, 2, TEST_DB_WRITER::bad_account, 3};
+
+    vector<std::shared_ptr<xmreg::WindowWrite>> windows (account_ids.size());
+    vector<std::atomic<int>> results (account_ids.size());
+    vector<std::thread> threads;
+
+    for (auto& result: results)
+        result = -1;
+
+    // first window is taken by the writer, which then waits in
+    // its commit, so that other windows are queued as one group
+    threads.push_back(write_window_of(writer, account_ids[0],
+                                      windows[0], results[0]));
+
+    writer.wait_for_commits(1);
+
+    for (size_t i = 1; i < account_ids.size(); ++i)
+        threads.push_back(write_window_of(writer, account_ids[i],
+                                          windows[i], results[i]));
+
+    writer.wait_for_queued(account_ids.size() - 1);
+
+    writer.open();
+
+    for (auto& t: threads)
+        t.join();
+
+    // only the bad window fails, others of its group
+    // are written again without it
+    EXPECT_EQ(results[0].load(), 1);
+    EXPECT_EQ(results[1].load(), 1);
+    EXPECT_EQ(results[2].load(), 0);
+    EXPECT_EQ(results[3].load(), 1);
+
+    EXPECT_TRUE(windows[1]->acc_updated);
+    EXPECT_FALSE(windows[2]->acc_updated);
+    EXPECT_TRUE(windows[3]->acc_updated);
+
+    EXPECT_EQ(writer.get_commit_sizes(),
+              (vector<size_t> {1, 3, 1, 1, 1}));
+}
+
+TEST(DB_WRITER, FailedSingleWindowIsNotWrittenAgain)
+{
+    TEST_DB_WRITER writer;
+
+    writer.open();
+
+    std::shared_ptr<xmreg::WindowWrite> window_write;
+    std::atomic<int> result {-1};
+
+    auto t = write_window_of(writer, TEST_DB_WRITER::bad_account,
+                             window_write, result);
+    t.join();
+
+    EXPECT_EQ(result.load(), 0);
+
+    EXPECT_EQ(writer.get_commit_sizes(), vector<size_t> {1});
+}
+
+
+// scanner with its own workers, as they are
+// created only when its thread starts
+class TEST_BLOCK_SCANNER : public xmreg::BlockScanner
+{
+public:
+
+    TEST_BLOCK_SCANNER(xmreg::CurrentBlockchainStatus* _current_bc_status)
+        : xmreg::BlockScanner(_current_bc_status)
+    {
+        workers = std::make_unique<xmreg::ScanWorkerPool>(2);
+    }
+
+    using xmreg::BlockScanner::scan_once;
+    using xmreg::BlockScanner::get_lookahead;
+    using xmreg::BlockScanner::update_window_cost;
+    using xmreg::BlockScanner::prefetched;
+};
+
+// window of blocks from h1 to h2 with the given number of
+// txs per block. txs are empty, as scan_window is mocked
+shared_ptr<xmreg::ScanWindow>
+make_scan_window(uint64_t h1, uint64_t h2, size_t txs_per_block = 1)
+{
+    auto window = make_shared<xmreg::ScanWindow>();
+
+    window->h1 = h1;
+    window->h2 = h2;
+    window->txs.resize((h2 - h1 + 1) * txs_per_block);
+
+    return window;
+}
+
+class BLOCK_SCANNER : public ::testing::Test
+{
+protected:
+
+    void
+    SetUp() override
+    {
+        bcs = std::make_unique<MockCurrentBlockchainStatus>();
+
+        // fixed windows of 10 blocks, without prefetching
+        bc_setup.blocks_search_lookahead = 10;
+        bc_setup.blocks_search_target_window_ms = 0;
+        bc_setup.blocks_search_max_window_txs = 0;
+        bc_setup.blocks_search_prefetch_depth = 0;
+
+        bcs->set_bc_setup(bc_setup);
+        bcs->current_height = 100;
+
+        scanner = std::make_unique<TEST_BLOCK_SCANNER>(bcs.get());
+    }
+
+    void
+    TearDown() override
+    {
+        // scanner waits for its prefetches, which use bcs
+        scanner.reset();
+    }
+
+    // account which is still searching, with searched_blk_no
+    // given for each scan_once, and the last one after that
+    shared_ptr<MockTxSearch>
+    add_search(vector<uint64_t> const& searched_blk_nos)
+    {
+        auto search = make_shared<MockTxSearch>();
+
+        EXPECT_CALL(*search, still_searching())
+                .WillRepeatedly(Return(true));
+
+        auto& expectation = EXPECT_CALL(*search, get_searched_blk_no());
+
+        for (uint64_t blk_no: searched_blk_nos)
+            expectation.WillOnce(Return(blk_no));
+
+        expectation.WillRepeatedly(Return(searched_blk_nos.back()));
+
+        searches.push_back(search);
+
+        EXPECT_CALL(*bcs, get_search_threads())
+                .WillRepeatedly(Return(searches));
+
+        return search;
+    }
+
+    xmreg::BlockchainSetup bc_setup;
+    std::unique_ptr<MockCurrentBlockchainStatus> bcs;
+    std::unique_ptr<TEST_BLOCK_SCANNER> scanner;
+    vector<shared_ptr<xmreg::TxSearch>> searches;
+};
+
+TEST_F(BLOCK_SCANNER, AccountsAreGroupedBySearchedBlkNo)
+{
+    auto search_10 = add_search({10});
+    auto search_15 = add_search({15});
+    auto search_19 = add_search({19});
+    auto search_40 = add_search({40});
+
+    auto window_10 = make_scan_window(10, 19);
+    auto window_40 = make_scan_window(40, 49);
+
+    // each window is read once, however many accounts use it
+    EXPECT_CALL(*bcs, get_scan_window(10, 19))
+            .WillOnce(Return(window_10));
+    EXPECT_CALL(*bcs, get_scan_window(40, 49))
+            .WillOnce(Return(window_40));
+
+    EXPECT_CALL(*search_10, scan_window(::testing::Ref(*window_10), _));
+    EXPECT_CALL(*search_15, scan_window(::testing::Ref(*window_10), _));
+    EXPECT_CALL(*search_19, scan_window(::testing::Ref(*window_10), _));
+    EXPECT_CALL(*search_40, scan_window(::testing::Ref(*window_40), _));
+
+    EXPECT_TRUE(scanner->scan_once());
+}
+
+TEST_F(BLOCK_SCANNER, AccountsAtTheTopOnlyCheckPings)
+{
+    auto search = add_search({101});
+
+    EXPECT_CALL(*bcs, get_scan_window(_, _)).Times(0);
+    EXPECT_CALL(*search, scan_window(_, _)).Times(0);
+    EXPECT_CALL(*search, stop_if_not_pinged());
+
+    EXPECT_FALSE(scanner->scan_once());
+}
+
+TEST_F(BLOCK_SCANNER, AccountStopsIfItsWindowCantBeRead)
+{
+    auto search = add_search({10});
+
+    EXPECT_CALL(*bcs, get_scan_window(10, 19))
+            .WillOnce(Return(nullptr));
+    EXPECT_CALL(*search, scan_window(_, _)).Times(0);
+
+    scanner->scan_once();
+
+    EXPECT_FALSE(search->TxSearch::still_searching());
+}
+
+TEST_F(BLOCK_SCANNER, NextWindowIsHandedOverFromPrefetch)
+{
+    bc_setup.blocks_search_prefetch_depth = 1;
+    bcs->set_bc_setup(bc_setup);
+
+    // account moves to the next window after the first scan_once
+    auto search = add_search({10, 20});
+
+    auto window_10 = make_scan_window(10, 19);
+    auto window_20 = make_scan_window(20, 29);
+
+    EXPECT_CALL(*bcs, get_scan_window(10, 19))
+            .WillOnce(Return(window_10));
+
+    // read in the background during the first scan_once,
+    // and not again when the account gets to it
+    EXPECT_CALL(*bcs, get_scan_window(20, 29))
+            .WillOnce(Return(window_20));
+
+    EXPECT_CALL(*bcs, get_scan_window(30, 39))
+            .WillRepeatedly(Return(make_scan_window(30, 39)));
+
+    EXPECT_CALL(*search, scan_window(::testing::Ref(*window_10), _));
+    EXPECT_CALL(*search, scan_window(::testing::Ref(*window_20), _));
+
+    EXPECT_TRUE(scanner->scan_once());
+
+    EXPECT_EQ(scanner->prefetched.count(20), 1);
+
+    EXPECT_TRUE(scanner->scan_once());
+
+    EXPECT_EQ(scanner->prefetched.count(20), 0);
+    EXPECT_EQ(scanner->prefetched.count(30), 1);
+}
+
+TEST_F(BLOCK_SCANNER, PrefetchedWindowIsDroppedAfterReorg)
+{
+    bc_setup.blocks_search_prefetch_depth = 1;
+    bcs->set_bc_setup(bc_setup);
+
+    auto search = add_search({10, 20});
+
+    auto window_10   = make_scan_window(10, 19);
+    auto orphaned_20 = make_scan_window(20, 29);
+    auto window_20   = make_scan_window(20, 29);
+
+    EXPECT_CALL(*bcs, get_scan_window(10, 19))
+            .WillOnce(Return(window_10));
+
+    // prefetched before the reorg, and read again after it
+    EXPECT_CALL(*bcs, get_scan_window(20, 29))
+            .WillOnce(Return(orphaned_20))
+            .WillOnce(Return(window_20));
+
+    EXPECT_CALL(*bcs, get_scan_window(30, 39))
+            .WillRepeatedly(Return(make_scan_window(30, 39)));
+
+    EXPECT_CALL(*search, scan_window(::testing::Ref(*window_10), _));
+    EXPECT_CALL(*search, scan_window(::testing::Ref(*window_20), _));
+
+    EXPECT_TRUE(scanner->scan_once());
+
+    // block 25 was replaced, while the height stays the same
+    scanner->invalidate_from(25);
+
+    EXPECT_TRUE(scanner->scan_once());
+}
+
+TEST_F(BLOCK_SCANNER, PrefetchedWindowBelowReorgIsKept)
+{
+    bc_setup.blocks_search_prefetch_depth = 1;
+    bcs->set_bc_setup(bc_setup);
+
+    auto search = add_search({10, 20});
+
+    auto window_10 = make_scan_window(10, 19);
+    auto window_20 = make_scan_window(20, 29);
+
+    EXPECT_CALL(*bcs, get_scan_window(10, 19))
+            .WillOnce(Return(window_10));
+    EXPECT_CALL(*bcs, get_scan_window(20, 29))
+            .WillOnce(Return(window_20));
+    EXPECT_CALL(*bcs, get_scan_window(30, 39))
+            .WillRepeatedly(Return(make_scan_window(30, 39)));
+
+    EXPECT_CALL(*search, scan_window(::testing::Ref(*window_10), _));
+    EXPECT_CALL(*search, scan_window(::testing::Ref(*window_20), _));
+
+    EXPECT_TRUE(scanner->scan_once());
+
+    scanner->invalidate_from(30);
+
+    EXPECT_TRUE(scanner->scan_once());
+}
+
+TEST_F(BLOCK_SCANNER, PrefetchedWindowAboveShorterBlockchainIsDropped)
+{
+    bc_setup.blocks_search_prefetch_depth = 1;
+    bcs->set_bc_setup(bc_setup);
+
+    auto search = add_search({10, 20});
+
+    auto window_10 = make_scan_window(10, 19);
+    auto window_20 = make_scan_window(20, 25);
+
+    EXPECT_CALL(*bcs, get_scan_window(10, 19))
+            .WillOnce(Return(window_10));
+    EXPECT_CALL(*bcs, get_scan_window(20, 29))
+            .WillOnce(Return(make_scan_window(20, 29)));
+
+    // blockchain is shorter now, so the window ends at its top
+    EXPECT_CALL(*bcs, get_scan_window(20, 25))
+            .WillOnce(Return(window_20));
+
+    EXPECT_CALL(*search, scan_window(::testing::Ref(*window_10), _));
+    EXPECT_CALL(*search, scan_window(::testing::Ref(*window_20), _));
+
+    EXPECT_TRUE(scanner->scan_once());
+
+    bcs->current_height = 25;
+
+    EXPECT_TRUE(scanner->scan_once());
+
+    EXPECT_TRUE(scanner->prefetched.empty());
+}
+
+TEST_F(BLOCK_SCANNER, LookaheadIsFixedUntilWindowIsScanned)
+{
+    bc_setup.blocks_search_target_window_ms = 1000;
+    bcs->set_bc_setup(bc_setup);
+
+    EXPECT_EQ(scanner->get_lookahead(10), 10);
+}
+
+TEST_F(BLOCK_SCANNER, LookaheadFollowsScanningTime)
+{
+    bc_setup.blocks_search_target_window_ms = 1000;
+    bc_setup.blocks_search_lookahead_min = 10;
+    bc_setup.blocks_search_lookahead_max = 10000;
+    bcs->set_bc_setup(bc_setup);
+
+    // 2 txs per block, each scanned in 1 ms
+    scanner->update_window_cost(*make_scan_window(0, 9, 2), 20000);
+
+    // so 1 s is enough for 500 blocks
+    EXPECT_EQ(scanner->get_lookahead(10), 500);
+
+    bc_setup.blocks_search_lookahead_max = 200;
+    bcs->set_bc_setup(bc_setup);
+
+    EXPECT_EQ(scanner->get_lookahead(10), 200);
+
+    // window scanned 100 times slower moves the average to
+    // 20.8 ms per tx, so 24 blocks, but not below the minimum
+    scanner->update_window_cost(*make_scan_window(10, 19, 2), 20000 * 100);
+
+    EXPECT_EQ(scanner->get_lookahead(20), 24);
+
+    bc_setup.blocks_search_lookahead_min = 30;
+    bcs->set_bc_setup(bc_setup);
+
+    EXPECT_EQ(scanner->get_lookahead(20), 30);
+}
+
+TEST_F(BLOCK_SCANNER, LookaheadIsLimitedByTxsInMemory)
+{
+    bc_setup.blocks_search_max_window_txs = 100;
+    bcs->set_bc_setup(bc_setup);
+
+    // density of the closest window below is used
+    scanner->update_window_cost(*make_scan_window(0, 9, 5), 1000);
+    scanner->update_window_cost(*make_scan_window(50, 59, 50), 1000);
+
+    EXPECT_EQ(scanner->get_lookahead(10), 10);
+    EXPECT_EQ(scanner->get_lookahead(60), 2);
+
+    // but never less than one block
+    scanner->update_window_cost(*make_scan_window(70, 70, 500), 1000);
+
+    EXPECT_EQ(scanner->get_lookahead(70), 1);
+}
+
+}
@@ -2,6 +2,8 @@
 #include "src/MicroCore.h"
 #include "../src/CurrentBlockchainStatus.h"
 #include "../src/ThreadRAII.h"
+#include "../src/TxSearch.h"
+#include "src/UniversalIdentifier.hpp"
 
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
@@ -510,5 +512,299 @@ using json = nlohmann::json;
 //json TXSEARCH_TEST::config_json;
 
 
+// blockchain which knows only public keys of ring members
+// of the given txs, as they are in their json files. its
+// enough for Input identifier, so that inputs it finds can
+// be compared with those found by global indices
+class RingMembersCore : public xmreg::AbstractCore
+{
+public:
+
+    // ring members are added under amounts of the inputs
+    // in jtx.tx, so that they can be changed before
+    void
+    add_ring_members(xmreg::JsonTx const& jtx)
+    {
+        size_t in_idx {0};
+
+        for (auto const& jinput: jtx.jtx["inputs"])
+        {
+            auto const& in_key = boost::get<txin_to_key>(
+                        jtx.tx.vin.at(in_idx++));
+
+            vector<uint64_t> offsets = jinput["absolute_offsets"];
+
+            for (size_t i = 0; i < offsets.size(); ++i)
+            {
+                public_key out_pk;
+
+                epee::string_tools::hex_to_pod(
+                        jinput["ring_members"][i]["ouput_pk"]
+                            .get<string>(), out_pk);
+
+                output_keys[{in_key.amount, offsets[i]}] = out_pk;
+            }
+        }
+    }
+
+    virtual uint64_t
+    get_num_outputs(uint64_t amount) const override
+    {
+        return 0;
+    }
+
+    virtual void
+    get_output_key(uint64_t amount,
+                   vector<uint64_t> const& absolute_offsets,
+                   vector<output_data_t>& outputs) const override
+    {
+        for (uint64_t global_index: absolute_offsets)
+        {
+            output_data_t out {};
+
+            auto it = output_keys.find({amount, global_index});
+
+            if (it != output_keys.end())
+                out.pubkey = it->second;
+
+            outputs.push_back(out);
+        }
+    }
+
+    virtual void
+    get_output_tx_and_index(
+            uint64_t amount,
+            std::vector<uint64_t> const& offsets,
+            std::vector<tx_out_index>& indices) const override
+    {}
+
+    virtual bool
+    get_tx(crypto::hash const& tx_hash, transaction& tx) const override
+    {
+        return false;
+    }
+
+    //                   amount  , global_index
+    std::map<std::pair<uint64_t, uint64_t>, public_key> output_keys;
+};
+
+// compares inputs found by global indices of known outputs
+// with those found by Input identifier using their public keys
+class INPUTS_BY_GLOBAL_INDEX : public ::testing::Test
+{
+protected:
+
+    void
+    SetUp() override
+    {
+        jtx = xmreg::construct_jsontx(
+            "ddff95211b53c194a16c2b8f37ae44b643b8bd46b4cb402af961ecabeb8417b2");
+    }
+
+    // ring member of the given input of jtx
+    // becomes our output with the given amount
+    void
+    add_our_ring_member(size_t in_idx, size_t member_idx,
+                        uint64_t amount, bool is_rct)
+    {
+        auto const& in_key = boost::get<txin_to_key>(jtx->tx.vin[in_idx]);
+
+        uint64_t global_index = relative_output_offsets_to_absolute(
+                    in_key.key_offsets).at(member_idx);
+
+        public_key out_pk = core.output_keys.at(
+                    {in_key.amount, global_index});
+
+        known_outputs[out_pk] = amount;
+
+        search.add_known_output_index(out_pk, amount,
+                                      global_index, is_rct);
+    }
+
+    vector<xmreg::IdentifiedInput>
+    identify_by_global_index(transaction const& tx) const
+    {
+        vector<xmreg::IdentifiedInput> inputs;
+        search.identify_inputs_by_global_index(tx, inputs);
+        return inputs;
+    }
+
+    vector<xmreg::IdentifiedInput>
+    identify_by_public_key(transaction const& tx)
+    {
+        auto const& sender = jtx->sender;
+
+        auto identifier = xmreg::make_identifier(tx,
+                            make_unique<xmreg::Input>(&sender.address,
+                                                      &sender.viewkey,
+                                                      &known_outputs,
+                                                      &core));
+        identifier.identify();
+
+        vector<xmreg::IdentifiedInput> inputs;
+
+        for (auto const& in_info: identifier.get<xmreg::Input>()->get())
+            inputs.push_back(
+                {in_info.key_img, in_info.amount, in_info.out_pub_key});
+
+        return inputs;
+    }
+
+    void
+    expect_same_inputs(transaction const& tx, size_t expected_no)
+    {
+        auto by_global_index = identify_by_global_index(tx);
+        auto by_public_key = identify_by_public_key(tx);
+
+        ASSERT_EQ(by_global_index.size(), expected_no);
+        ASSERT_EQ(by_public_key.size(), expected_no);
+
+        for (size_t i = 0; i < expected_no; ++i)
+        {
+            EXPECT_EQ(by_global_index[i].key_img, by_public_key[i].key_img);
+            EXPECT_EQ(by_global_index[i].amount, by_public_key[i].amount);
+            EXPECT_EQ(by_global_index[i].out_pub_key,
+                      by_public_key[i].out_pub_key);
+        }
+    }
+
+    boost::optional<xmreg::JsonTx> jtx;
+
+    RingMembersCore core;
+    xmreg::TxSearch::known_outputs_t known_outputs;
+    xmreg::TxSearch search;
+};
+
+TEST_F(INPUTS_BY_GLOBAL_INDEX, NoKnownOutputs)
+{
+    ASSERT_TRUE(jtx);
+
+    core.add_ring_members(*jtx);
+
+    expect_same_inputs(jtx->tx, 0);
+}
+
+TEST_F(INPUTS_BY_GLOBAL_INDEX, ManyRingMembersAreOurs)
+{
+    ASSERT_TRUE(jtx);
+
+    core.add_ring_members(*jtx);
+
+    // two members of the first input and one of the
+    // second one. each is reported on its own
+    add_our_ring_member(0, 2, 1000, true);
+    add_our_ring_member(0, 7, 2000, true);
+    add_our_ring_member(1, 0, 3000, true);
+
+    expect_same_inputs(jtx->tx, 3);
+
+    auto inputs = identify_by_global_index(jtx->tx);
+
+    EXPECT_EQ(inputs[0].amount, 1000);
+    EXPECT_EQ(inputs[1].amount, 2000);
+    EXPECT_EQ(inputs[2].amount, 3000);
+
+    EXPECT_EQ(inputs[0].key_img, inputs[1].key_img);
+    EXPECT_NE(inputs[0].key_img, inputs[2].key_img);
+}
+
+TEST_F(INPUTS_BY_GLOBAL_INDEX, PreRingctOutputsAreNotUnderAmountZero)
+{
+    ASSERT_TRUE(jtx);
+
+    core.add_ring_members(*jtx);
+
+    add_our_ring_member(0, 3, 1000, true);
+
+    // pre-ringct output with the same global index as the
+    // ring member, but among outputs of its own amount. its
+    // a different output, so it is not found
+    auto const& in_key = boost::get<txin_to_key>(jtx->tx.vin[1]);
+
+    uint64_t global_index = relative_output_offsets_to_absolute(
+                in_key.key_offsets).at(4);
+
+    public_key pre_rct_pk = crypto::rand<public_key>();
+
+    known_outputs[pre_rct_pk] = 5000000000000;
+
+    search.add_known_output_index(pre_rct_pk, 5000000000000,
+                                  global_index, false);
+
+    expect_same_inputs(jtx->tx, 1);
+}
+
+TEST_F(INPUTS_BY_GLOBAL_INDEX, PreRingctInputsAreMatchedByTheirAmount)
+{
+    ASSERT_TRUE(jtx);
+
+    uint64_t const amount {5000000000000};
+
+    // same tx, but as if its inputs were pre-ringct
+    for (auto& in: jtx->tx.vin)
+        boost::get<txin_to_key>(in).amount = amount;
+
+    core.add_ring_members(*jtx);
+
+    add_our_ring_member(0, 1, amount, false);
+    add_our_ring_member(1, 5, amount, false);
+
+    // ringct output with the same global index is not
+    // a ring member of pre-ringct input
+    auto const& in_key = boost::get<txin_to_key>(jtx->tx.vin[0]);
+
+    uint64_t global_index = relative_output_offsets_to_absolute(
+                in_key.key_offsets).at(6);
+
+    public_key rct_pk = crypto::rand<public_key>();
+
+    known_outputs[rct_pk] = 1000;
+    search.add_known_output_index(rct_pk, 1000, global_index, true);
+
+    expect_same_inputs(jtx->tx, 2);
+
+    for (auto const& input: identify_by_global_index(jtx->tx))
+        EXPECT_EQ(input.amount, amount);
+}
+
+TEST_F(INPUTS_BY_GLOBAL_INDEX, V2CoinbaseOutputsAreUnderAmountZero)
+{
+    ASSERT_TRUE(jtx);
+
+    auto coinbase_jtx = xmreg::construct_jsontx(
+            "f3c84fe925292ec5b4dc383d306d934214f4819611566051bca904d1cf4efceb");
+
+    ASSERT_TRUE(coinbase_jtx);
+    ASSERT_EQ(coinbase_jtx->tx.version, 2);
+
+    core.add_ring_members(*jtx);
+
+    // coinbase output has its amount in clear, but its
+    // global index is among ringct outputs. so, ringct input
+    // can have it as a ring member
+    auto const& coinbase_out = coinbase_jtx->recipients.at(0).outputs.at(0);
+
+    auto const& in_key = boost::get<txin_to_key>(jtx->tx.vin[0]);
+
+    uint64_t global_index = relative_output_offsets_to_absolute(
+                in_key.key_offsets).at(9);
+
+    core.output_keys[{0, global_index}] = coinbase_out.pub_key;
+
+    known_outputs[coinbase_out.pub_key] = coinbase_out.amount;
+
+    // same as in TxSearch::scan_window
+    search.add_known_output_index(coinbase_out.pub_key,
+                                  coinbase_out.amount,
+                                  global_index,
+                                  coinbase_jtx->tx.version == 2);
+
+    expect_same_inputs(jtx->tx, 1);
+
+    auto inputs = identify_by_global_index(jtx->tx);
+
+    EXPECT_EQ(inputs[0].amount, coinbase_out.amount);
+    EXPECT_EQ(inputs[0].out_pub_key, coinbase_out.pub_key);
+}
 
 }